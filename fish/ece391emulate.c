@@ -225,3 +225,28 @@ ece391_close (int32_t fd)
     return 0;
 }
 
+int32_t 
+ece391_sbrk (int32_t increment)
+{
+    void* old = sbrk (increment);
+
+    return (void*)-1 == old ? -1 : (int32_t)old;
+}
+
+int32_t 
+ece391_mmap_anon (uint32_t length, uint8_t** start)
+{
+    void* mem;
+
+    if ((mem = mmap ((void*)0, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+        return -1;
+    *start = mem;
+    return 0;
+}
+
+int32_t 
+ece391_munmap (uint8_t* start, uint32_t length)
+{
+    return munmap (start, length);
+}
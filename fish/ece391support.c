@@ -51,3 +51,108 @@ ece391_strncmp (const uint8_t* s1, const uint8_t* s2, uint32_t n)
     return ((int32_t)*s1) - ((int32_t)*s2);
 }
 
+/*
+ * User heap. Blocks start with a header holding their size (header
+ * included), free blocks are kept on an address ordered list through the
+ * header and merged with free neighbours. The heap grows with sbrk in
+ * ECE391_HEAP_GROW steps. Blocks of ECE391_MMAP_MIN bytes or more get an
+ * anonymous mapping of their own that goes back to the kernel on free.
+ */
+#define ECE391_ALIGN      8
+#define ECE391_HEAP_GROW  16384
+#define ECE391_MMAP_MIN   65536
+#define ECE391_MMAPPED    1
+
+typedef struct ece391_block {
+    uint32_t size;
+    struct ece391_block* next;  /* only while free */
+} ece391_block_t;
+
+#define ECE391_HDR        sizeof(ece391_block_t)
+
+static ece391_block_t* ece391_free_list;
+
+/* Puts a block on the free list, merging it with adjacent free blocks */
+static void
+ece391_free_block (ece391_block_t* b)
+{
+    ece391_block_t* prev = 0;
+    ece391_block_t* cur = ece391_free_list;
+
+    while (0 != cur && cur < b) {
+        prev = cur;
+        cur = cur->next;
+    }
+    b->next = cur;
+    if (0 != cur && (uint8_t*)b + b->size == (uint8_t*)cur) {
+        b->size += cur->size;
+        b->next = cur->next;
+    }
+    if (0 == prev) {
+        ece391_free_list = b;
+    } else if ((uint8_t*)prev + prev->size == (uint8_t*)b) {
+        prev->size += b->size;
+        prev->next = b->next;
+    } else {
+        prev->next = b;
+    }
+}
+
+void*
+ece391_malloc (uint32_t size)
+{
+    ece391_block_t** link;
+    ece391_block_t* b;
+    ece391_block_t* rest;
+    uint8_t* mem;
+    uint32_t need, grow;
+
+    if (0 == size || size > ECE391_MMAP_MIN * 64)
+        return 0;
+    need = (size + ECE391_HDR + ECE391_ALIGN - 1) & ~(ECE391_ALIGN - 1);
+    if (need >= ECE391_MMAP_MIN) {
+        if (-1 == ece391_mmap_anon (need, &mem))
+            return 0;
+        b = (ece391_block_t*)mem;
+        b->size = need | ECE391_MMAPPED;
+        return mem + ECE391_HDR;
+    }
+
+    while (1) {
+        for (link = &ece391_free_list; 0 != (b = *link); link = &b->next) {
+            if (b->size < need)
+                continue;
+            if (b->size - need >= 2 * ECE391_HDR) {
+                rest = (ece391_block_t*)((uint8_t*)b + need);
+                rest->size = b->size - need;
+                rest->next = b->next;
+                *link = rest;
+                b->size = need;
+            } else {
+                *link = b->next;
+            }
+            return (uint8_t*)b + ECE391_HDR;
+        }
+        grow = (need + ECE391_HEAP_GROW - 1) & ~(ECE391_HEAP_GROW - 1);
+        b = (ece391_block_t*)ece391_sbrk (grow);
+        if ((ece391_block_t*)-1 == b)
+            return 0;
+        b->size = grow;
+        ece391_free_block (b);
+    }
+}
+
+void
+ece391_free (void* ptr)
+{
+    ece391_block_t* b;
+
+    if (0 == ptr)
+        return;
+    b = (ece391_block_t*)((uint8_t*)ptr - ECE391_HDR);
+    if (b->size & ECE391_MMAPPED) {
+        (void)ece391_munmap ((uint8_t*)b, b->size & ~ECE391_MMAPPED);
+        return;
+    }
+    ece391_free_block (b);
+}
@@ -19,6 +19,64 @@ extern int32_t ece391_open (const uint8_t* filename);
 extern int32_t ece391_close (int32_t fd);
 extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
+extern int32_t ece391_mmap (int32_t fd, uint8_t** start);
+extern int32_t ece391_fork (void);
+extern int32_t ece391_sbrk (int32_t increment);
+extern int32_t ece391_mmap_anon (uint32_t length, uint8_t** start);
+extern int32_t ece391_munmap (uint8_t* start, uint32_t length);
+
+/*
+ * System call ring. Submissions are queued at sq_tail with a system call
+ * number (SYS_READ, SYS_WRITE, SYS_OPEN or SYS_CLOSE) and its arguments,
+ * ece391_ring_enter runs them and posts completions at cq_tail, to be
+ * reaped from cq_head. Indices only grow, entries are at index %
+ * RING_ENTRIES.
+ */
+#define RING_ENTRIES 64
+
+typedef struct {
+    uint32_t op;
+    int32_t arg[3];
+    uint32_t user_data;
+} ring_sqe_t;
+
+typedef struct {
+    uint32_t user_data;
+    int32_t result;
+} ring_cqe_t;
+
+typedef struct {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    ring_sqe_t sq[RING_ENTRIES];
+    ring_cqe_t cq[RING_ENTRIES];
+} syscall_ring_t;
+
+extern int32_t ece391_ring_setup (syscall_ring_t** ring);
+extern int32_t ece391_ring_enter (uint32_t count);
+
+/*
+ * Pipes. ece391_pipe puts the read end in fds[0] and the write end in
+ * fds[1]. Reads block until data arrives and return 0 once every write end
+ * is closed, writes block while the pipe is full. ece391_dup2 makes newfd
+ * (which may be 0 or 1) refer to what oldfd does, closing newfd first.
+ */
+extern int32_t ece391_pipe (int32_t fds[2]);
+extern int32_t ece391_dup2 (int32_t oldfd, int32_t newfd);
+
+/*
+ * Maps the shared memory segment called name, creating it zero filled if
+ * no process maps it. *start picks the address (in the 148MB window) or is
+ * NULL for any, and gets the address of the mapping. ece391_munmap unmaps.
+ */
+extern int32_t ece391_shm_map (const uint8_t* name, uint32_t length, uint8_t** start);
+
+/* the same calls entered with sysenter instead of int $0x80 */
+extern int32_t ece391_fast_read (int32_t fd, void* buf, int32_t nbytes);
+extern int32_t ece391_fast_write (int32_t fd, const void* buf, int32_t nbytes);
+extern int32_t ece391_fast_sigreturn (void);
 
 #endif /* ECE391SYSCALL_H */
 
@@ -1,45 +1,120 @@
 #include "filesys.h"
 
+// dentry index for each hash slot, DENTRY_HASH_EMPTY if unused
+static uint8_t dentry_hash[DENTRY_HASH_SIZE];
+
+/* dentry_hash_name
+ * FNV-1a hash of a file name. Stops at the null terminator or after
+ * NAME_SIZE bytes, since names that fill the whole field are not terminated.
+ * parameters - name, len - set to number of bytes hashed (may be NULL)
+ * returns - hash of name
+ */
+static uint32_t dentry_hash_name(const uint8_t* name, uint32_t* len) {
+    uint32_t i;
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for(i = 0; i < NAME_SIZE && name[i] != '\0'; i++) {
+        hash ^= name[i];
+        hash *= FNV_PRIME;
+    }
+    if(len) *len = i;
+    return hash;
+}
+
+/* dentry_name_eq
+ * Compares a name against a dentry file_name field, which is only
+ * terminated if shorter than NAME_SIZE. Bytes up to and including the
+ * name's terminator have to match. With SSE2 all NAME_SIZE bytes are
+ * compared at once into a bit mask of equal bytes, otherwise strncmp
+ * compares a word at a time. Interrupts are off while the XMM registers
+ * are in use, they are not saved on a context switch.
+ * parameters - name : NAME_SIZE readable bytes, zero padded
+ *              len : length of name
+ *              file_name
+ * returns - 1 if equal, 0 otherwise
+ */
+static int32_t dentry_name_eq(const uint8_t* name, uint32_t len, const uint8_t* file_name) {
+    uint32_t eq, need, flags;
+
+    if(!(mem_features & MEM_SSE2))
+        return strncmp((int8_t*)name, (int8_t*)file_name, NAME_SIZE) == 0;
+    // bits 0..len, a full length name has no terminator to match
+    need = len < NAME_SIZE ? (2u << len) - 1 : 0xFFFFFFFF;
+    cli_and_save(flags);
+    asm volatile ("                         \n\
+            movdqu  (%1), %%xmm0            \n\
+            movdqu  16(%1), %%xmm1          \n\
+            movdqu  (%2), %%xmm2            \n\
+            movdqu  16(%2), %%xmm3          \n\
+            pcmpeqb %%xmm2, %%xmm0          \n\
+            pcmpeqb %%xmm3, %%xmm1          \n\
+            pmovmskb %%xmm0, %0             \n\
+            pmovmskb %%xmm1, %%edx          \n\
+            shll    $16, %%edx              \n\
+            orl     %%edx, %0               \n\
+            "
+            : "=&r"(eq)
+            : "r"(name), "r"(file_name)
+            : "edx", "memory", "cc" XMM0_3_CLOBBER
+    );
+    restore_flags(flags);
+    return (~eq & need) == 0;
+}
+
 /* fs_init - CP2
- * Initializes global vars.
+ * Initializes global vars and builds the dentry name index.
  * parameters - fs - mod->mod_start needs to be passed in here from kernel.c
  * returns - none
  */
 void fs_init(void* fs) {
+    uint32_t i, slot, num_dentries;
     filesystem = fs;
     boot = (bootblk_t*)filesystem;
     inode_arr = &((inode_t*)filesystem)[1]; // accessing first inode (4KB)
     data_arr = &((dblk_t*)filesystem)[1 + boot->num_of_inodes]; // accessing first data block (4KB)
     den_arr = &((dentry_t*)boot)[1]; // accessing first dentry by casting bootblock (64B)
     dir_offset = 0;
+
+    // index only the used dentries, linear probing on collision
+    memset(dentry_hash, DENTRY_HASH_EMPTY, DENTRY_HASH_SIZE);
+    num_dentries = boot->num_of_dirE;
+    if(num_dentries > MAX_FILE_COUNT) num_dentries = MAX_FILE_COUNT;
+    for(i = 0; i < num_dentries; i++) {
+        slot = dentry_hash_name(boot->dir_entries[i].file_name, NULL) & DENTRY_HASH_MASK;
+        while(dentry_hash[slot] != DENTRY_HASH_EMPTY)
+            slot = (slot + 1) & DENTRY_HASH_MASK;
+        dentry_hash[slot] = i;
+    }
 }
 
 /* read_dentry_by_name - CP2
  * Fills dentry block with file name, file type, inode number using the
- * given fname if it exists.
+ * given fname if it exists. Looks the name up in the index built by fs_init.
  * parameters - fname, dentry
  * returns - 0 (success), -1 (failure)
  */
 int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry) {
-    int i;
-    int name_len = strlen((int8_t*)fname);
-    if(!filesystem) { // if no filesystem
+    uint32_t slot, name_len;
+    uint8_t name[NAME_SIZE];
+    if(!filesystem || fname == NULL) { // if no filesystem
         return -1;
     }
-    if(name_len > NAME_SIZE) { // if name size invalid
+    slot = dentry_hash_name(fname, &name_len) & DENTRY_HASH_MASK;
+    // if name empty or name size invalid
+    if(name_len == 0 || (name_len == NAME_SIZE && fname[NAME_SIZE] != '\0')) {
         return -1;
     }
-    if(name_len != NAME_SIZE){
-        name_len += 1; // for null termination
-    }
-
-    for(i = 0; i < MAX_FILE_COUNT; i++) { // for all files, check for fname
-        dentry_t* cur_dir = &(boot->dir_entries[i]);
+    // padded copy, so the compare can read NAME_SIZE bytes
+    memcpy_small(name, fname, name_len);
+    memset_small(name + name_len, 0, NAME_SIZE - name_len);
 
-        if(strncmp((int8_t*)fname, (int8_t*)cur_dir->file_name, name_len) == 0){
+    // probe until an empty slot, table is never full
+    while(dentry_hash[slot] != DENTRY_HASH_EMPTY) {
+        dentry_t* cur_dir = &(boot->dir_entries[dentry_hash[slot]]);
+        if(dentry_name_eq(name, name_len, cur_dir->file_name)) {
             *dentry = *cur_dir; // get block
             return 0;
         }
+        slot = (slot + 1) & DENTRY_HASH_MASK;
     }
     return -1; // if not found
 }
@@ -125,7 +200,7 @@ int32_t read_data (uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t lengt
 int32_t file_read(int32_t fd, void* buf, int32_t nbytes) {
     uint32_t num_read;
     // now that we added pcb, must adjust this function with fd
-    pcb_t* pcb = get_pcb(t[t_visible].running_process);
+    pcb_t* pcb = get_pcb(cur_pid);
     // sanity check
     if(fd >= FD_MAX || fd < FD_START) return -1;
     if(!filesystem) {
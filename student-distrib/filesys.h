@@ -12,6 +12,13 @@
 #define DENTRY_RESERVE   24
 #define MAX_INODE_BLOCK  1023
 
+// open-addressing name index over boot->dir_entries, built in fs_init
+#define DENTRY_HASH_SIZE   128     // power of two, over 2x MAX_FILE_COUNT
+#define DENTRY_HASH_MASK   (DENTRY_HASH_SIZE - 1)
+#define DENTRY_HASH_EMPTY  0xFF
+#define FNV_OFFSET_BASIS   0x811C9DC5
+#define FNV_PRIME          0x01000193
+
 // single 64B directory entry within the boot block
 typedef struct __attribute__((packed)) {
     unsigned char file_name[NAME_SIZE];
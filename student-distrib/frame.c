@@ -0,0 +1,185 @@
+#include "frame.h"
+#include "lib.h"
+
+// one bit per 4KB frame below FRAME_MAX, set while the frame is in use
+static uint32_t frame_map[FRAME_WORDS];
+// no word of frame_map below this one has a free frame
+static uint32_t frame_hint;
+// references to a frame beyond the first, for pages shared after fork
+static uint16_t frame_refs[FRAME_MAX / _4_KB];
+
+uint32_t frames_free;
+uint32_t frames_total;
+uint32_t frame_top;
+
+/* frame_mark
+ * description - marks the frames overlapping [start, end) used or free
+ * parameters - start, end : physical range, clipped to FRAME_MIN-FRAME_MAX
+ *              used : 1 to reserve, 0 to release
+ * returns - none
+ */
+static void frame_mark(uint32_t start, uint32_t end, int32_t used) {
+    uint32_t f;
+    if(start < FRAME_MIN) start = FRAME_MIN;
+    if(end > FRAME_MAX) end = FRAME_MAX;
+    for(f = start / _4_KB; f < end / _4_KB; ++f) {
+        if(used && !(frame_map[f / FRAME_BITS] & (1 << (f % FRAME_BITS)))) {
+            frame_map[f / FRAME_BITS] |= 1 << (f % FRAME_BITS);
+            frames_free--;
+        } else if(!used && (frame_map[f / FRAME_BITS] & (1 << (f % FRAME_BITS)))) {
+            frame_map[f / FRAME_BITS] &= ~(1 << (f % FRAME_BITS));
+            frames_free++;
+        }
+    }
+}
+
+/* frame_init - CP5
+ * description - everything starts out used, then the available regions of
+ *               the multiboot memory map (or mem_upper if there is no map)
+ *               are released and the boot modules reserved again. Only
+ *               whole frames inside a region are used.
+ * parameters - mbi : multiboot information from the boot loader
+ * returns - none
+ */
+void frame_init(multiboot_info_t* mbi) {
+    uint32_t i, start, end;
+    memory_map_t* mmap;
+    module_t* mod;
+
+    for(i = 0; i < FRAME_WORDS; ++i)
+        frame_map[i] = FRAME_WORD_FULL;
+    frames_free = 0;
+    frame_top = FRAME_MIN;
+
+    if(mbi->flags & MB_FLAG_MMAP) {
+        for(mmap = (memory_map_t*)mbi->mmap_addr;
+                (uint32_t)mmap < mbi->mmap_addr + mbi->mmap_length;
+                mmap = (memory_map_t*)((uint32_t)mmap + mmap->size + sizeof(mmap->size))) {
+            // nothing above 4GB can be reached without PAE
+            if(mmap->type != MMAP_AVAILABLE || mmap->base_addr_high)
+                continue;
+            start = (mmap->base_addr_low + _4_KB - 1) & ~(_4_KB - 1);
+            end = mmap->base_addr_low + mmap->length_low;
+            if(mmap->length_high || end < mmap->base_addr_low)
+                end = FRAME_MAX;
+            end &= ~(_4_KB - 1);
+            frame_mark(start, end, 0);
+        }
+    } else if(mbi->flags & MB_FLAG_MEM) {
+        // mem_upper is in KB, starting at 1MB
+        frame_mark(_1_MB, _1_MB + mbi->mem_upper * _1_KB, 0);
+    }
+
+    if(mbi->flags & MB_FLAG_MODS) {
+        for(i = 0, mod = (module_t*)mbi->mods_addr; i < mbi->mods_count; ++i, ++mod)
+            frame_mark(mod->mod_start & ~(_4_KB - 1), (mod->mod_end + _4_KB - 1) & ~(_4_KB - 1), 1);
+    }
+
+    frames_total = frames_free;
+    for(i = FRAME_MAX / _4_KB; i > FRAME_MIN / _4_KB; --i) {
+        if(!(frame_map[(i - 1) / FRAME_BITS] & (1 << ((i - 1) % FRAME_BITS)))) {
+            frame_top = (i * _4_KB + _4_MB - 1) & ~(_4_MB - 1);
+            break;
+        }
+    }
+    frame_hint = FRAME_MIN / _4_KB / FRAME_BITS;
+}
+
+/* frame_alloc - CP5
+ * description - takes the lowest free frame. Full words of the bitmap are
+ *               skipped 32 frames at a time and the search starts at the
+ *               first word that can have a free frame.
+ * parameters - none
+ * returns - physical address of the frame, 0 if memory is exhausted
+ */
+uint32_t frame_alloc(void) {
+    uint32_t i, bit;
+    for(i = frame_hint; i < FRAME_WORDS; ++i) {
+        if(frame_map[i] != FRAME_WORD_FULL) {
+            asm("bsfl %1, %0" : "=r"(bit) : "r"(~frame_map[i]));
+            frame_map[i] |= 1 << bit;
+            frame_hint = i;
+            frames_free--;
+            return (i * FRAME_BITS + bit) * _4_KB;
+        }
+    }
+    frame_hint = FRAME_WORDS;
+    return 0;
+}
+
+/* frame_alloc_n - CP5
+ * description - first fit search for n contiguous free frames
+ * parameters - n : number of frames
+ * returns - physical address of the first frame, 0 on failure
+ */
+uint32_t frame_alloc_n(uint32_t n) {
+    uint32_t f, run;
+    if(n == 0)
+        return 0;
+    for(f = frame_hint * FRAME_BITS, run = 0; f < FRAME_MAX / _4_KB; ++f) {
+        if(frame_map[f / FRAME_BITS] & (1 << (f % FRAME_BITS))) {
+            run = 0;
+            continue;
+        }
+        if(++run == n) {
+            f = f + 1 - n;
+            frame_mark(f * _4_KB, (f + n) * _4_KB, 1);
+            return f * _4_KB;
+        }
+    }
+    return 0;
+}
+
+/* frame_free - CP5
+ * description - returns a frame to the allocator once its last reference
+ *               is dropped
+ * parameters - addr : physical address from frame_alloc
+ * returns - none
+ */
+void frame_free(uint32_t addr) {
+    uint32_t f = addr / _4_KB;
+    if(addr < FRAME_MIN || addr >= FRAME_MAX)
+        return;
+    if(frame_refs[f] > 0) {
+        frame_refs[f]--;
+        return;
+    }
+    frame_mark(addr, addr + _4_KB, 0);
+    if(f / FRAME_BITS < frame_hint)
+        frame_hint = f / FRAME_BITS;
+}
+
+/* frame_free_n - CP5
+ * description - returns n contiguous frames to the allocator
+ * parameters - addr : physical address from frame_alloc_n
+ *              n : number of frames
+ * returns - none
+ */
+void frame_free_n(uint32_t addr, uint32_t n) {
+    uint32_t i;
+    for(i = 0; i < n; ++i)
+        frame_free(addr + i * _4_KB);
+}
+
+/* frame_share - CP5
+ * description - counts one more mapping of a frame, frame_free then only
+ *               drops that reference
+ * parameters - addr : physical address of a frame in use
+ * returns - none
+ */
+void frame_share(uint32_t addr) {
+    if(addr < FRAME_MIN || addr >= FRAME_MAX)
+        return;
+    frame_refs[addr / _4_KB]++;
+}
+
+/* frame_shared - CP5
+ * description - tells whether a frame has more than one reference
+ * parameters - addr : physical address of a frame in use
+ * returns - 1 if shared, 0 otherwise
+ */
+int32_t frame_shared(uint32_t addr) {
+    if(addr < FRAME_MIN || addr >= FRAME_MAX)
+        return 0;
+    return frame_refs[addr / _4_KB] > 0;
+}
@@ -0,0 +1,45 @@
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include "types.h"
+#include "multiboot.h"
+
+/* Physical memory is handed out in 4KB frames tracked by a bitmap. Frames
+ * start above the kernel (and the boot stack at 8MB) and end below 128MB,
+ * since the kernel maps all of that memory 1:1 with 4MB pages and the user
+ * windows start at virtual 128MB. */
+#define FRAME_MIN           _8_MB
+#define FRAME_MAX           _128_MB
+#define FRAME_BITS          32
+#define FRAME_WORDS         (FRAME_MAX / _4_KB / FRAME_BITS)
+#define FRAME_WORD_FULL     0xFFFFFFFF
+
+// multiboot flags for mem_*, mods_* and mmap_* being valid
+#define MB_FLAG_MEM         0x01
+#define MB_FLAG_MODS        0x08
+#define MB_FLAG_MMAP        0x40
+// memory map entry type of usable RAM
+#define MMAP_AVAILABLE      1
+
+// frames that are free, and usable RAM frames at boot
+extern uint32_t frames_free;
+extern uint32_t frames_total;
+// end of usable RAM, rounded up to 4MB, the kernel direct map ends here
+extern uint32_t frame_top;
+
+// seeds the allocator from the multiboot memory map
+void frame_init(multiboot_info_t* mbi);
+// takes one free frame, returns its physical address or 0 if none is left
+uint32_t frame_alloc(void);
+// takes n physically contiguous frames, returns the first or 0 on failure
+uint32_t frame_alloc_n(uint32_t n);
+// gives a frame back, or drops one reference if it is shared
+void frame_free(uint32_t addr);
+// adds a reference to a frame that another mapping now shares
+void frame_share(uint32_t addr);
+// 1 if more than one mapping references the frame
+int32_t frame_shared(uint32_t addr);
+// gives n contiguous frames back
+void frame_free_n(uint32_t addr, uint32_t n);
+
+#endif /* _FRAME_H */
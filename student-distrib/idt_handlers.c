@@ -22,7 +22,9 @@ void invalid_tss_ex();
 void seg_not_pres_ex();
 void stack_fault_ex();
 void gen_prot_ex();
-void page_fault_ex();
+void page_fault_ex(uint32_t addr, uint32_t err);
+// page faults need the error code and CR2, so they go through asm linkage
+void page_fault_ex_handler();
 // 15 reserved by intel
 void reserved();
 void fpu_fp_ex();
@@ -58,6 +60,9 @@ void initialize_idt() {
         install_interrupt_handler(j, &undefined_handler, 0, 0);
     }
 
+    // page faults can be serviced (demand paging) and return to the program
+    install_interrupt_handler(PAGE_FAULT_IDX, page_fault_ex_handler, 0, 0);
+
     // install RTC (IRQ8)
     install_interrupt_handler(RTC_IDX, rtc_handler_link, 0, 0);
     // install keyboard (IRQ1)
@@ -139,10 +144,8 @@ void rtc_handler() {
     outb(REG_C, SELECT_REG);
     inb(DATA_REG);
 
-    // update volatile flag while interrupts disabled
-    if(!rtc_int_received) {
-        rtc_int_received = 1;
-    }
+    // count the tick while interrupts disabled, wakes readers that are due
+    rtc_tick();
 
     // rtc test for CP1
 	// test_interrupts();
@@ -322,14 +325,22 @@ void gen_prot_ex() {
     halt(USER_PROG_CODE);
 }
 /*  page_fault_ex
-    DESCRIPTION: handler functions for page fault exception
-    INPUTS: none
-    OUTPUTS: writes the interrupt to the screen, and then freezes with a while loop
+    DESCRIPTION: handler functions for page fault exception. Not present pages
+                 in the program window are loaded on first touch, writes to
+                 pages shared after fork are copied, anything else is a real
+                 fault.
+    INPUTS: addr - faulting linear address (CR2)
+            err - error code pushed by the processor
+    OUTPUTS: writes the interrupt to the screen if the fault can't be serviced
     RETURN VALUE: none
-    SIDE EFFECTS: freezes the kernel
+    SIDE EFFECTS: maps a page, or halts the program
 */
-void page_fault_ex() {
-    printf("Page-Fault Exception (#PF)\n");
+void page_fault_ex(uint32_t addr, uint32_t err) {
+    if(!(err & PF_PRESENT) && page_in(addr) == 0)
+        return;
+    if((err & PF_PRESENT) && (err & PF_WRITE) && cow_fault(addr) == 0)
+        return;
+    printf("Page-Fault Exception (#PF) at 0x%#x\n", addr);
     halt(USER_PROG_CODE);
 }
 /*  reserved
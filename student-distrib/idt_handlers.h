@@ -9,10 +9,16 @@
 #define RTC_IDX 0x28
 #define KEYBOARD_IDX 0x21
 #define PIT_IDX 0x20
+#define PAGE_FAULT_IDX 0x0E
 #define USER_LEVEL  3
 
 #define USER_PROG_CODE 255
 
+// page fault error code bit set when the page was present
+#define PF_PRESENT  0x01
+// page fault error code bit set on a write
+#define PF_WRITE    0x02
+
 // initialize IDT at bootup
 extern void initialize_idt();
 
@@ -15,15 +15,34 @@
 #include "filesys.h"
 #include "system_calls.h"
 #include "scheduler.h"
+#include "frame.h"
+#include "kmalloc.h"
+#include "pipe.h"
 
 #define RUN_TESTS   0
 
-int p;
-
 /* Macros. */
 /* Check if the bit BIT in FLAGS is set. */
 #define CHECK_FLAG(flags, bit)   ((flags) & (1 << (bit)))
 
+/* CPUID leaf 1 EDX bit for sysenter/sysexit, and the MSRs they use */
+#define CPUID_SEP               11
+#define MSR_SYSENTER_CS         0x174
+#define MSR_SYSENTER_ESP        0x175
+#define MSR_SYSENTER_EIP        0x176
+
+/* Lets user programs enter system calls with sysenter. sysexit returns to
+ * the segments that follow KERNEL_CS in the GDT, USER_CS and USER_DS. */
+static void sysenter_init(void) {
+    if(!CHECK_FLAG(cpuid(CPUID_FEATURES, NULL, NULL, NULL), CPUID_SEP)) {
+        printf("sysenter not supported, only int $0x80 system calls\n");
+        return;
+    }
+    wrmsr(MSR_SYSENTER_CS, KERNEL_CS, 0);
+    wrmsr(MSR_SYSENTER_ESP, (uint32_t)&sysenter_entry_esp, 0);
+    wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_handler_link, 0);
+}
+
 /* Check if MAGIC is valid and print the Multiboot information structure
    pointed by ADDR. */
 void entry(unsigned long magic, unsigned long addr) {
@@ -145,10 +164,19 @@ void entry(unsigned long magic, unsigned long addr) {
         ltr(KERNEL_TSS);
     }
 
-    for(p = 0; p < PROCESS_COUNT; p++)
-        process_status[p] = -1;
+    /* Pick the memcpy/memset strategies the CPU supports */
+    mem_init();
+
+    /* Hand out the RAM from the memory map in 4KB frames, and allow as many
+     * processes as it can hold */
+    frame_init(mbi);
+    kmalloc_init();
+    pipe_init();
+    process_init();
+    printf("%u free frames, up to %u processes\n", frames_free, process_limit);
     /* Init the IDT */
     initialize_idt();
+    sysenter_init();
     /* Init the PIC */
     i8259_init();
     /* Initialize devices, memory, filesystem, enable device interrupts on the
@@ -156,10 +184,10 @@ void entry(unsigned long magic, unsigned long addr) {
     keyboard_init();
     paging_init();
     initialize_rtc();
-    /* PIT has been written, but not fully debugged so initialization is commented out. */
-    // pit_init();
     // initialize the terminal
     terminal_init();
+    /* Preempt every time slice, round robin over runnable processes */
+    pit_init();
     /* Enable interrupts */
     /* Do not enable the following until after you have set up your
      * IDT correctly otherwise QEMU will triple fault and simple close
@@ -171,14 +199,11 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Run tests */
     //launch_tests();
 #endif
-    /* Execute the first program ("shell") ... */
-    pcb_t* pcb = get_pcb(0);
-    asm volatile(
-        "movl %%esp, %0     \n"
-        "movl %%ebp, %1     \n"
-        :"=r"(pcb->cur_esp), "=r"(pcb->cur_ebp) // output
-        : // input
-    );
+    /* Execute the first program ("shell") ... pid 0 has a kernel stack of
+     * its own, so the boot stack is abandoned once the shell starts. Other
+     * terminals start theirs when shown. */
+    t_cur = 0;
+    t_visible = 0;
     execute((uint8_t*)"shell");
 
     /* Spin (nicely, so we don't chew up cycles) */
@@ -1,6 +1,7 @@
 #include "keyboard.h"
 #include "paging.h"
 #include "system_calls.h"
+#include "scheduler.h"
 
 // format copied from https://stackoverflow.com/questions/61124564/convert-scancodes-to-ascii
 // 0: none 1: shift 2: caps_lock 3: caps_lock && shift
@@ -125,19 +126,43 @@ static uint8_t shift_flag;
 static uint8_t alt_flag;
 static uint8_t ctrl_flag;
 static uint8_t enter_flag[3];
+// processes in terminal_read waiting for a line in each terminal
+static wait_queue_t enter_wq[TERMINAL_COUNT];
+
+// scancodes from the top half to the bottom half. Only the interrupt
+// handler advances kbd_tail and only the bottom half kbd_head, so neither
+// needs a lock. Both only grow, entries are at index % KBD_RING_SIZE.
+static volatile uint8_t kbd_ring[KBD_RING_SIZE];
+static volatile uint32_t kbd_head;
+static volatile uint32_t kbd_tail;
+// set while the bottom half drains the ring
+static volatile uint8_t kbd_bh_running;
+uint32_t kbd_dropped;
 
 /*  enter_pressed
- *  DESCRIPTION: return if enter is pressed
- *  INPUTS: none
+ *  DESCRIPTION: return if enter is pressed in a terminal
+ *  INPUTS: tid -- terminal to check
  *  OUTPUTS: 1 (true) if pressed 0 if not
  *  RETURN VALUE: none
  *  SIDE EFFECTS: none */
-uint8_t get_enter_flag(void) {
-    return enter_flag[t_visible];
+uint8_t get_enter_flag(int32_t tid) {
+    return enter_flag[tid];
 }
 
-void release_enter(void) {
-    enter_flag[t_visible] = 0;
+void release_enter(int32_t tid) {
+    enter_flag[tid] = 0;
+}
+
+/*  wait_for_line
+ *  DESCRIPTION: sleeps until enter is pressed or the line buffer fills up in
+ *               a terminal. Must be called with interrupts off.
+ *  INPUTS: tid -- terminal to wait on
+ *  OUTPUTS: none
+ *  RETURN VALUE: none
+ *  SIDE EFFECTS: the caller leaves the run queue while it waits */
+void wait_for_line(int32_t tid) {
+    while (t[tid].buffer_idx < BUF_SIZE - 1 && !enter_flag[tid])
+        sleep_on(&enter_wq[tid]);
 }
 
 /*  keyboard_init
@@ -152,22 +177,44 @@ void keyboard_init(void) {
     shift_flag = 0;
     alt_flag = 0;
     ctrl_flag = 0;
-    for (i = 0; i < TERMINAL_COUNT; ++i)
-        enter_flag[t_visible] = 0;
+    for (i = 0; i < TERMINAL_COUNT; ++i) {
+        enter_flag[i] = 0;
+        enter_wq[i].head = NO_PID;
+        enter_wq[i].tail = NO_PID;
+    }
+    kbd_head = 0;
+    kbd_tail = 0;
+    kbd_bh_running = 0;
+    kbd_dropped = 0;
     enable_irq(KEYBOARD_IRQ);
 }
 
-/*  keyboard_handler
- *  DESCRIPTION: installs the interrupt handler for the RTC
- *  INPUTS: none
+/*  kbd_ring_pop
+ *  DESCRIPTION: takes the oldest scancode off the ring
+ *  INPUTS: scan_code -- where the scancode goes
+ *  OUTPUTS: none
+ *  RETURN VALUE: 1 if there was one, 0 if the ring is empty
+ *  SIDE EFFECTS: none */
+static int32_t kbd_ring_pop(uint8_t* scan_code) {
+    if (kbd_head == kbd_tail)
+        return 0;
+    *scan_code = kbd_ring[kbd_head % KBD_RING_SIZE];
+    // the slot is free for the producer only after it was read
+    asm volatile ("" : : : "memory");
+    kbd_head++;
+    return 1;
+}
+
+/*  keyboard_process
+ *  DESCRIPTION: the bottom half's work for one scancode: modifier state, line
+ *               discipline, echo and terminal switching
+ *  INPUTS: scan_code -- scancode from the ring
  *  OUTPUTS: change keyboard flag or echo key based on the input
  *  RETURN VALUE: none
  *  SIDE EFFECTS: modifies terminal */
-void keyboard_handler(void) {
-    uint8_t scan_code, key_ascii, which_keys;   // store scan code and translation to ascii
+static void keyboard_process(uint8_t scan_code) {
+    uint8_t key_ascii, which_keys;   // translation to ascii
 
-    send_eoi(KEYBOARD_IRQ);
-    scan_code = inb(KEYBOARD_PORT);
     // check special cases
     switch(scan_code) {
         case CAPS_LOCK_PRS:
@@ -206,13 +253,25 @@ void keyboard_handler(void) {
         case ENTER_PRS:
             // t[0], t[1], t[2]
             enter_flag[t_visible] = 1;
-            putc('\n');
+            term_putc(t_visible, '\n');
+            wake_up(&enter_wq[t_visible]);
+            return;
+
+        // Shift+PageUp/PageDown browse the history a screen at a time
+        case PAGE_UP_PRS:
+            if (shift_flag)
+                term_scrollback(t_visible, NUM_ROWS - 1);
+            return;
+
+        case PAGE_DOWN_PRS:
+            if (shift_flag)
+                term_scrollback(t_visible, -(NUM_ROWS - 1));
             return;
 
         case BACKSPACE_PRS:
         if (t[t_visible].buffer_idx) {
                 t[t_visible].buffer[--t[t_visible].buffer_idx] = '\0';  // buffer limiter
-                putc('\b');
+                term_putc(t_visible, '\b');
             }
             return;
 
@@ -234,39 +293,16 @@ void keyboard_handler(void) {
             // switch to terminal 2
             case F2:
                 switch_display(terminal_2);
-                // if base shell is not executed in terminal 1
-                if(t[terminal_2].shell_flag == -1) {
-                    pcb_t* pcb = get_pcb(terminal_2);
-
-                    asm volatile(
-                        "movl %%esp, %0     \n"
-                        "movl %%ebp, %1     \n"
-                        :"=r"(pcb->cur_esp), "=r"(pcb->cur_ebp) // output
-                        : // input
-                    );
-                    t[t_visible].running_process = terminal_2;
-                    execute((uint8_t*)"shell");
-                }
                 break;
             // switch to terminal 3
             case F3:
                 switch_display(terminal_3);
-                // if base shell is not executed in terminal 2
-                if(t[terminal_3].shell_flag == -1) {
-                    pcb_t* pcb = get_pcb(terminal_3);
-
-                    asm volatile(
-                        "movl %%esp, %0     \n"
-                        "movl %%ebp, %1     \n"
-                        :"=r"(pcb->cur_esp), "=r"(pcb->cur_ebp) // output
-                        : // input
-                    );
-                    t[t_visible].running_process = terminal_3;
-                    execute((uint8_t*)"shell");
-                }
                 break;
-            default: ;
+            default:
+                return;
         }
+        // start the base shell the first time a terminal is shown
+        sched_spawn_shell(t_visible);
         return;
     }
     // check for CTRL-L
@@ -283,9 +319,63 @@ void keyboard_handler(void) {
         } else if (t[t_visible].buffer_idx == BUF_SIZE - 2) {
             t[t_visible].buffer[t[t_visible].buffer_idx++] = '\n';
             t[t_visible].buffer[t[t_visible].buffer_idx] = '\0';  // line limiter
+            // the line is full, hand it to the reader
+            wake_up(&enter_wq[t_visible]);
         } else
             t[t_visible].buffer_idx = 0;
-        putc(key_ascii);
+        term_putc(t_visible, key_ascii);
     }
     return;
 }
+
+/*  keyboard_bottom_half
+ *  DESCRIPTION: drains the ring with interrupts on, so echo and scrolling
+ *               do not hold off other interrupts and keys typed meanwhile
+ *               are queued instead of lost. The PIT does not switch away
+ *               until the ring is empty. A keyboard interrupt that arrives
+ *               while it runs only queues its scancode, this loop picks it
+ *               up. Called with interrupts off.
+ *  INPUTS: none
+ *  OUTPUTS: none
+ *  RETURN VALUE: none
+ *  SIDE EFFECTS: returns with interrupts off */
+static void keyboard_bottom_half(void) {
+    uint8_t scan_code;
+
+    if (kbd_bh_running)
+        return;
+    kbd_bh_running = 1;
+    preempt_disable();
+    // the ring is checked with interrupts off, so a scancode can't slip in
+    // after the last check and before kbd_bh_running is cleared
+    while (kbd_ring_pop(&scan_code)) {
+        sti();
+        keyboard_process(scan_code);
+        cli();
+    }
+    preempt_enable();
+    kbd_bh_running = 0;
+}
+
+/*  keyboard_handler
+ *  DESCRIPTION: top half of the keyboard interrupt: queues the scancode and
+ *               acknowledges the PIC, then runs the bottom half unless it
+ *               is already running lower on the stack
+ *  INPUTS: none
+ *  OUTPUTS: none
+ *  RETURN VALUE: none
+ *  SIDE EFFECTS: a full ring drops the scancode (counted in kbd_dropped) */
+void keyboard_handler(void) {
+    uint8_t scan_code = inb(KEYBOARD_PORT);
+
+    if (kbd_tail - kbd_head < KBD_RING_SIZE) {
+        kbd_ring[kbd_tail % KBD_RING_SIZE] = scan_code;
+        // publish the slot before the new tail
+        asm volatile ("" : : : "memory");
+        kbd_tail++;
+    } else
+        kbd_dropped++;
+    send_eoi(KEYBOARD_IRQ);
+
+    keyboard_bottom_half();
+}
@@ -23,20 +23,29 @@
 #define CTRL_REL        (CTRL_PRS | REL_MASK)
 #define ENTER_PRS       0x1C
 #define BACKSPACE_PRS   0x0E
+#define PAGE_UP_PRS     0x49
+#define PAGE_DOWN_PRS   0x51
 #define terminal_1      0
 #define terminal_2      1
 #define terminal_3      2
 
+// scancodes the interrupt handler can queue for the bottom half, a power
+// of two so the free running indices wrap cleanly
+#define KBD_RING_SIZE   128
+
 // function keys for changing terminals
 #define F1              0x3B
 #define F2              0x3C
 #define F3              0x3D
 
-extern uint8_t get_enter_flag(void);
-extern void release_enter(void);
+extern uint8_t get_enter_flag(int32_t tid);
+extern void release_enter(int32_t tid);
+extern void wait_for_line(int32_t tid);
 // initializes keyboard by setting the default flag and enabling on the PIC
 extern void keyboard_init(void);
-// installs the interrupt handler for the RTC
+// top half of the keyboard interrupt, queues the scancode
 extern void keyboard_handler(void);
+// scancodes dropped because the ring was full
+extern uint32_t kbd_dropped;
 
 #endif
@@ -0,0 +1,218 @@
+#include "kmalloc.h"
+#include "frame.h"
+#include "lib.h"
+
+// power of two caches kmalloc takes small objects from
+static kmem_cache_t size_caches[KMALLOC_CLASSES];
+static const int8_t* size_names[KMALLOC_CLASSES] = {
+    "kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024"
+};
+// every cache, size classes first
+static kmem_cache_t* cache_list;
+
+uint32_t kmalloc_big_frames;
+
+/* cache_setup
+ * description - fills in a cache with no slabs yet
+ * parameters - cache : cache to set up
+ *              name : shown by kmalloc_stats
+ *              size : object size in bytes
+ * returns - none
+ */
+static void cache_setup(kmem_cache_t* cache, const int8_t* name, uint32_t size) {
+    kmem_cache_t** last;
+    if(size < sizeof(void*))
+        size = sizeof(void*);
+    cache->name = name;
+    cache->size = (size + KMEM_ALIGN - 1) & ~(KMEM_ALIGN - 1);
+    cache->per_slab = (_4_KB - sizeof(slab_t)) / cache->size;
+    cache->partial = NULL;
+    cache->next = NULL;
+    cache->slabs = 0;
+    cache->objs_in_use = 0;
+    cache->allocs = 0;
+    cache->frees = 0;
+    for(last = &cache_list; *last != NULL; last = &(*last)->next);
+    *last = cache;
+}
+
+/* slab_grow
+ * description - gives a cache a new slab with every object free
+ * parameters - cache : cache without free objects
+ * returns - the slab, NULL if memory is exhausted
+ */
+static slab_t* slab_grow(kmem_cache_t* cache) {
+    slab_t* slab = (slab_t*)frame_alloc();
+    uint8_t* obj;
+    uint32_t i;
+    if(slab == NULL)
+        return NULL;
+    slab->cache = cache;
+    slab->in_use = 0;
+    // link the objects in address order
+    obj = (uint8_t*)(slab + 1);
+    slab->free = obj;
+    for(i = 0; i + 1 < cache->per_slab; ++i, obj += cache->size)
+        *(void**)obj = obj + cache->size;
+    *(void**)obj = NULL;
+    slab->next = cache->partial;
+    cache->partial = slab;
+    cache->slabs++;
+    return slab;
+}
+
+/* kmalloc_init - CP5
+ * description - sets up the power of two caches, they get slabs on first use
+ * parameters - none
+ * returns - none
+ */
+void kmalloc_init(void) {
+    int i;
+    cache_list = NULL;
+    kmalloc_big_frames = 0;
+    for(i = 0; i < KMALLOC_CLASSES; ++i)
+        cache_setup(&size_caches[i], size_names[i], KMALLOC_MIN << i);
+}
+
+/* kmem_cache_create - CP5
+ * description - makes a cache for objects of one type, so they pack without
+ *               rounding up to a power of two
+ * parameters - name : shown by kmalloc_stats, must stay valid
+ *              size : object size, at most KMALLOC_MAX
+ * returns - the cache, NULL on failure
+ */
+kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t size) {
+    kmem_cache_t* cache;
+    uint32_t flags;
+    if(size == 0 || size > KMALLOC_MAX)
+        return NULL;
+    if((cache = kmalloc(sizeof(kmem_cache_t))) == NULL)
+        return NULL;
+    cli_and_save(flags);
+    cache_setup(cache, name, size);
+    restore_flags(flags);
+    return cache;
+}
+
+/* kmem_cache_alloc - CP5
+ * description - takes the first free object of the first partial slab. A
+ *               slab that runs out leaves the partial list.
+ * parameters - cache : cache to allocate from
+ * returns - the object, NULL if memory is exhausted
+ */
+void* kmem_cache_alloc(kmem_cache_t* cache) {
+    slab_t* slab;
+    void* obj;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if((slab = cache->partial) == NULL && (slab = slab_grow(cache)) == NULL) {
+        restore_flags(flags);
+        return NULL;
+    }
+    obj = slab->free;
+    slab->free = *(void**)obj;
+    if(++slab->in_use == cache->per_slab)
+        cache->partial = slab->next;
+    cache->objs_in_use++;
+    cache->allocs++;
+    restore_flags(flags);
+    return obj;
+}
+
+/* kmem_cache_free - CP5
+ * description - puts an object back on its slab's free list. A slab that
+ *               was full goes back on the partial list, an empty one is
+ *               given back to the frame allocator unless it is the only
+ *               partial slab left.
+ * parameters - cache : cache the object came from
+ *              obj : object to free
+ * returns - none
+ */
+void kmem_cache_free(kmem_cache_t* cache, void* obj) {
+    slab_t* slab = (slab_t*)((uint32_t)obj & ~(_4_KB - 1));
+    slab_t** link;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    *(void**)obj = slab->free;
+    slab->free = obj;
+    if(slab->in_use-- == cache->per_slab) {
+        slab->next = cache->partial;
+        cache->partial = slab;
+    }
+    cache->objs_in_use--;
+    cache->frees++;
+
+    if(slab->in_use == 0 && !(cache->partial == slab && slab->next == NULL)) {
+        for(link = &cache->partial; *link != slab; link = &(*link)->next);
+        *link = slab->next;
+        frame_free((uint32_t)slab);
+        cache->slabs--;
+    }
+    restore_flags(flags);
+}
+
+/* kmalloc - CP5
+ * description - small sizes come from the smallest size class that fits,
+ *               bigger ones get contiguous frames headed by a slab_t with
+ *               no cache
+ * parameters - size : bytes needed
+ * returns - the memory, NULL on failure
+ */
+void* kmalloc(uint32_t size) {
+    slab_t* big;
+    uint32_t n;
+    int i;
+
+    if(size == 0)
+        return NULL;
+    if(size <= KMALLOC_MAX) {
+        for(i = 0; (KMALLOC_MIN << i) < size; ++i);
+        return kmem_cache_alloc(&size_caches[i]);
+    }
+    n = (size + sizeof(slab_t) + _4_KB - 1) / _4_KB;
+    if((big = (slab_t*)frame_alloc_n(n)) == NULL)
+        return NULL;
+    big->cache = NULL;
+    big->next = NULL;
+    big->free = NULL;
+    big->in_use = n;
+    kmalloc_big_frames += n;
+    return big + 1;
+}
+
+/* kfree - CP5
+ * description - finds the slab header at the start of the pointer's frame
+ *               to tell which cache the memory goes back to
+ * parameters - ptr : memory from kmalloc
+ * returns - none
+ */
+void kfree(void* ptr) {
+    slab_t* slab;
+    if(ptr == NULL)
+        return;
+    slab = (slab_t*)((uint32_t)ptr & ~(_4_KB - 1));
+    if(slab->cache != NULL) {
+        kmem_cache_free(slab->cache, ptr);
+        return;
+    }
+    kmalloc_big_frames -= slab->in_use;
+    frame_free_n((uint32_t)slab, slab->in_use);
+}
+
+/* kmalloc_stats - CP5
+ * description - prints objects in use, slabs and call counts of every cache
+ * parameters - none
+ * returns - none
+ */
+void kmalloc_stats(void) {
+    kmem_cache_t* cache;
+    printf("cache          size  in use  slabs  allocs  frees\n");
+    for(cache = cache_list; cache != NULL; cache = cache->next) {
+        printf("%s  %u  %u  %u  %u  %u\n", cache->name, cache->size,
+               cache->objs_in_use, cache->slabs, cache->allocs, cache->frees);
+    }
+    printf("big allocations: %u frames\n", kmalloc_big_frames);
+}
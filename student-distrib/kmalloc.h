@@ -0,0 +1,59 @@
+#ifndef _KMALLOC_H
+#define _KMALLOC_H
+
+#include "types.h"
+
+/* Kernel heap. Small objects come from slab caches: every slab is one 4KB
+ * frame whose header is followed by equal sized objects, and a free object
+ * holds the link to the next free one. kmalloc picks a power of two cache,
+ * objects of a fixed type can get a cache of their own with
+ * kmem_cache_create. Anything bigger than KMALLOC_MAX gets whole frames. */
+#define KMALLOC_MIN_SHIFT   4
+#define KMALLOC_MAX_SHIFT   10
+#define KMALLOC_MIN         (1 << KMALLOC_MIN_SHIFT)
+#define KMALLOC_MAX         (1 << KMALLOC_MAX_SHIFT)
+#define KMALLOC_CLASSES     (KMALLOC_MAX_SHIFT - KMALLOC_MIN_SHIFT + 1)
+#define KMEM_ALIGN          4
+
+struct kmem_cache;
+
+// header at the start of every slab frame
+typedef struct slab {
+    struct kmem_cache* cache; // NULL for a kmalloc bigger than KMALLOC_MAX
+    struct slab* next;        // next slab of the cache with free objects
+    void* free;               // first free object
+    uint32_t in_use;          // objects handed out, frames of a big kmalloc
+} slab_t;
+
+typedef struct kmem_cache {
+    const int8_t* name;
+    uint32_t size;            // object size, rounded up to KMEM_ALIGN
+    uint32_t per_slab;        // objects that fit in a slab
+    slab_t* partial;          // slabs with at least one free object
+    struct kmem_cache* next;  // every cache, for kmalloc_stats
+    // statistics
+    uint32_t slabs;
+    uint32_t objs_in_use;
+    uint32_t allocs;
+    uint32_t frees;
+} kmem_cache_t;
+
+// sets up the kmalloc size classes
+void kmalloc_init(void);
+// makes a cache for objects of one size
+kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t size);
+// takes an object from a cache, NULL if memory is exhausted
+void* kmem_cache_alloc(kmem_cache_t* cache);
+// gives an object back to its cache
+void kmem_cache_free(kmem_cache_t* cache, void* obj);
+// allocates size bytes of kernel memory, NULL on failure
+void* kmalloc(uint32_t size);
+// frees memory from kmalloc, NULL is ignored
+void kfree(void* ptr);
+// prints the statistics of every cache
+void kmalloc_stats(void);
+
+// frames held by big kmallocs
+extern uint32_t kmalloc_big_frames;
+
+#endif /* _KMALLOC_H */
@@ -11,13 +11,22 @@ static char* video_mem = (char *)VID_MEM;
 /* void clear(void);
  * Inputs: void
  * Return Value: none
- * Function: Clears video memory */
+ * Function: Clears the screen of the running process' terminal */
 void clear(void) {
-    int32_t i;
-    for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
-        *(uint8_t *)(video_mem + (i << 1)) = ' ';
-        *(uint8_t *)(video_mem + (i << 1) + 1) = ATTRIB;
-    }
+    term_clear(t_cur);
+}
+
+/* void term_clear(int32_t tid);
+ * Inputs: tid = terminal to clear
+ * Return Value: none
+ * Function: Blanks the screen rows of a terminal, lines already scrolled
+ *           into its history are kept */
+void term_clear(int32_t tid) {
+    int32_t y;
+    for (y = 0; y < NUM_ROWS; y++)
+        memset_word(term_line(tid, y), (ATTRIB << 8) | ' ', NUM_COLS);
+    t[tid].view = 0;
+    term_blit(tid);
 }
 
 /* Standard printf().
@@ -160,45 +169,134 @@ int32_t puts(int8_t* s) {
     return index;
 }
 
+/* int32_t putn(const uint8_t* buf, int32_t n);
+ *   Inputs: buf = characters to print, n = how many
+ *   Return Value: Number of bytes written
+ *    Function: Output a buffer to the running process' terminal */
+int32_t putn(const uint8_t* buf, int32_t n) {
+    return term_putn(t_cur, buf, n);
+}
+
+/* int32_t term_putn(int32_t tid, const uint8_t* buf, int32_t n);
+ *   Inputs: tid = terminal to write to, buf = characters to print, n = how many
+ *   Return Value: Number of bytes written
+ *    Function: Output a buffer to a terminal in bulk. Characters go into the
+ *              terminal's scrollback ring, where a scroll only advances the
+ *              ring, and the screen is drawn from the ring once at the end
+ *              together with the hardware cursor. Same output as putc on
+ *              every byte. */
+int32_t term_putn(int32_t tid, const uint8_t* buf, int32_t n) {
+    int32_t i;
+    uint32_t x, y;
+    uint16_t* line;
+    uint8_t c;
+
+    x = t[tid].screen_x;
+    y = t[tid].screen_y;
+    line = term_line(tid, y);
+    for (i = 0; i < n; i++) {
+        c = buf[i];
+        if (c == '\n' || c == '\r') {
+            x = 0;
+            if (++y == NUM_ROWS) {
+                scroll_up(tid);
+                y--;
+            }
+            line = term_line(tid, y);
+        } else if (c == '\b') {
+            if (x)
+                x--;
+            else if (y) {
+                y--;
+                x = NUM_COLS - 1;
+                line = term_line(tid, y);
+            } else
+                continue;
+            line[x] = (ATTRIB << 8) | ' ';
+        } else if (c) {
+            line[x] = (ATTRIB << 8) | c;
+            if (++x == NUM_COLS) {
+                x = 0;
+                if (++y == NUM_ROWS) {
+                    scroll_up(tid);
+                    y--;
+                }
+                line = term_line(tid, y);
+            }
+        }
+    }
+    t[tid].screen_x = x;
+    t[tid].screen_y = y;
+    // new output brings a terminal back from its history
+    t[tid].view = 0;
+    term_blit(tid);
+    if (tid == t_visible)
+        update_cursor();
+    return n;
+}
+
 /* void putc(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
- *  Function: Output a character to the console */
+ *  Function: Output a character to the running process' terminal */
 void putc(uint8_t c) {
+    term_putc(t_cur, c);
+}
+
+/* void term_putc(int32_t tid, uint8_t c);
+ * Inputs: tid = terminal to write to, c = character to print
+ * Return Value: void
+ *  Function: Output a character to a terminal. The cell is written to the
+ *            scrollback ring and to the terminal's video page; the page is
+ *            only redrawn from the ring when the terminal scrolled or was
+ *            showing its history */
+void term_putc(int32_t tid, uint8_t c) {
+    uint16_t* mem;
+    uint16_t cell;
+    int32_t redraw;
     if (!c) return;
+    mem = (uint16_t*)term_video(tid);
+    redraw = t[tid].view != 0;
+    t[tid].view = 0;
+
     if(c == '\n' || c == '\r') {
-        if (++t[t_visible].screen_y >= NUM_ROWS) {
-            scroll_up();
-            t[t_visible].screen_y--;
+        if (++t[tid].screen_y >= NUM_ROWS) {
+            scroll_up(tid);
+            t[tid].screen_y--;
+            redraw = 1;
         }
-        t[t_visible].screen_x = 0;
+        t[tid].screen_x = 0;
     // in case of backspace: move back a x or y if x == 0, move back a buffer
     } else if(c == '\b') {
-        if (t[t_visible].screen_x)
-            --t[t_visible].screen_x;
-        else {
-            // do nothing if none
-            if (!t[t_visible].screen_y) return;
-            --t[t_visible].screen_y;
-            t[t_visible].screen_x = NUM_COLS - 1;
+        if (t[tid].screen_x)
+            --t[tid].screen_x;
+        else if (t[tid].screen_y) {
+            --t[tid].screen_y;
+            t[tid].screen_x = NUM_COLS - 1;
+        } else
+            c = 0;  // do nothing if none
+        if (c) {
+            cell = (ATTRIB << 8) | ' ';
+            term_line(tid, t[tid].screen_y)[t[tid].screen_x] = cell;
+            mem[NUM_COLS * t[tid].screen_y + t[tid].screen_x] = cell;
         }
-        *(uint8_t *)(video_mem + ((NUM_COLS * t[t_visible].screen_y + t[t_visible].screen_x) << 1)) = ' ';
-        *(uint8_t *)(video_mem + ((NUM_COLS * t[t_visible].screen_y + t[t_visible].screen_x) << 1) + 1) = ATTRIB;
     } else {
-        *(uint8_t *)(video_mem + ((NUM_COLS * t[t_visible].screen_y + t[t_visible].screen_x) << 1)) = c;
-        *(uint8_t *)(video_mem + ((NUM_COLS * t[t_visible].screen_y + t[t_visible].screen_x) << 1) + 1) = ATTRIB;
-        ++t[t_visible].screen_x;
-    }
-    if (t[t_visible].screen_x == NUM_COLS && t[t_visible].screen_y < NUM_ROWS - 1) {
-        ++t[t_visible].screen_y;
-        t[t_visible].screen_x = 0;
-    } else if (t[t_visible].screen_x == NUM_COLS && t[t_visible].screen_y >= NUM_ROWS - 1) {
-        ++t[t_visible].screen_y;
-        scroll_up();
-        --t[t_visible].screen_y;
-        t[t_visible].screen_x = 0;
+        cell = (ATTRIB << 8) | c;
+        term_line(tid, t[tid].screen_y)[t[tid].screen_x] = cell;
+        mem[NUM_COLS * t[tid].screen_y + t[tid].screen_x] = cell;
+        if (++t[tid].screen_x == NUM_COLS) {
+            t[tid].screen_x = 0;
+            if (++t[tid].screen_y >= NUM_ROWS) {
+                scroll_up(tid);
+                t[tid].screen_y--;
+                redraw = 1;
+            }
+        }
     }
-    update_cursor();
+    if (redraw)
+        term_blit(tid);
+    if (tid == t_visible)
+        update_cursor();
 }
 
 
@@ -263,22 +361,57 @@ int8_t* strrev(int8_t* s) {
 /* uint32_t strlen(const int8_t* s);
  * Inputs: const int8_t* s = string to take length of
  * Return Value: length of string s
- * Function: return length of string s */
+ * Function: return length of string s, scanning a word at a time */
 uint32_t strlen(const int8_t* s) {
-    register uint32_t len = 0;
-    while (s[len] != '\0')
-        len++;
-    return len;
+    const int8_t* p = s;
+    const uint32_t* w;
+    // bytes up to a word boundary, an aligned word never reaches into a
+    // page the string does not
+    for(; (uint32_t)p & 0x3; ++p)
+        if(*p == '\0')
+            return p - s;
+    for(w = (const uint32_t*)p; !HAS_ZERO(*w); ++w);
+    for(p = (const int8_t*)w; *p != '\0'; ++p);
+    return p - s;
 }
 
-/* void* memset(void* s, int32_t c, uint32_t n);
+uint32_t mem_features;
+
+/* void mem_init(void);
+ * Inputs: none
+ * Return Value: none
+ * Function: picks the memcpy/memset strategies from CPUID. The XMM registers
+ *           can only be used once CR4.OSFXSR is set and CR0.EM is clear. */
+void mem_init(void) {
+    uint32_t max_leaf, ebx, cr;
+
+    mem_features = 0;
+    cpuid(0, &max_leaf, NULL, NULL);
+    if(cpuid(CPUID_FEATURES, NULL, NULL, NULL) & CPUID_EDX_SSE) {
+        asm volatile ("movl %%cr0, %0" : "=r"(cr));
+        cr = (cr & ~CR0_EM) | CR0_MP;
+        asm volatile ("movl %0, %%cr0" : : "r"(cr));
+        asm volatile ("movl %%cr4, %0" : "=r"(cr));
+        cr |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+        asm volatile ("movl %0, %%cr4" : : "r"(cr));
+        mem_features |= MEM_SSE;
+        if(cpuid(CPUID_FEATURES, NULL, NULL, NULL) & CPUID_EDX_SSE2)
+            mem_features |= MEM_SSE2;
+    }
+    if(max_leaf >= CPUID_EXT_FEATURES) {
+        cpuid(CPUID_EXT_FEATURES, NULL, &ebx, NULL);
+        if(ebx & CPUID_EBX_ERMS)
+            mem_features |= MEM_ERMS;
+    }
+}
+
+/* void set_stosl(void* s, int32_t c, uint32_t n);
  * Inputs:    void* s = pointer to memory
- *          int32_t c = value to set memory to
+ *          int32_t c = byte value to set memory to
  *         uint32_t n = number of bytes to set
- * Return Value: new string
- * Function: set n consecutive bytes of pointer s to value c */
-void* memset(void* s, int32_t c, uint32_t n) {
-    c &= 0xFF;
+ * Return Value: none
+ * Function: aligns s to 4 bytes, then rep stosl and a byte tail */
+static void set_stosl(void* s, int32_t c, uint32_t n) {
     asm volatile ("                 \n\
             .memset_top:            \n\
             testl   %%ecx, %%ecx    \n\
@@ -306,10 +439,104 @@ void* memset(void* s, int32_t c, uint32_t n) {
             jmp     .memset_bottom  \n\
             .memset_done:           \n\
             "
-            :
-            : "a"(c << 24 | c << 16 | c << 8 | c), "D"(s), "c"(n)
+            : "+D"(s), "+c"(n)
+            : "a"(c << 24 | c << 16 | c << 8 | c)
+            : "edx", "memory", "cc"
+    );
+}
+
+/* void set_erms(void* s, int32_t c, uint32_t n);
+ * Inputs:    void* s = pointer to memory
+ *          int32_t c = byte value to set memory to
+ *         uint32_t n = number of bytes to set
+ * Return Value: none
+ * Function: rep stosb, which CPUs with ERMS run a cache line at a time */
+static void set_erms(void* s, int32_t c, uint32_t n) {
+    asm volatile ("                 \n\
+            movw    %%ds, %%dx      \n\
+            movw    %%dx, %%es      \n\
+            cld                     \n\
+            rep     stosb           \n\
+            "
+            : "+D"(s), "+c"(n)
+            : "a"(c)
             : "edx", "memory", "cc"
     );
+}
+
+/* void set_sse(void* s, int32_t c, uint32_t n);
+ * Inputs:    void* s = pointer to memory
+ *          int32_t c = byte value to set memory to
+ *         uint32_t n = number of bytes to set, at least SSE_ALIGN
+ * Return Value: none
+ * Function: aligns s to 16 bytes and stores 64 bytes per iteration from
+ *           XMM0. The XMM registers are not saved on a context switch, so
+ *           interrupts stay off while they are in use. */
+static void set_sse(void* s, int32_t c, uint32_t n) {
+    uint8_t* d = s;
+    uint32_t pattern[SSE_ALIGN / 4];
+    uint32_t head, count, flags;
+
+    pattern[0] = pattern[1] = pattern[2] = pattern[3] = c * 0x01010101;
+    head = -(uint32_t)d & (SSE_ALIGN - 1);
+    memset_small(d, c, head);
+    d += head;
+    n -= head;
+
+    cli_and_save(flags);
+    // each asm loads the pattern itself, XMM0 is not kept between them
+    if((count = n / SSE_BLOCK) > 0) {
+        asm volatile ("                     \n\
+            movups  (%2), %%xmm0            \n\
+            1:                              \n\
+            movaps  %%xmm0, (%0)            \n\
+            movaps  %%xmm0, 16(%0)          \n\
+            movaps  %%xmm0, 32(%0)          \n\
+            movaps  %%xmm0, 48(%0)          \n\
+            addl    $64, %0                 \n\
+            decl    %1                      \n\
+            jnz     1b                      \n\
+            "
+            : "+r"(d), "+r"(count)
+            : "r"(pattern)
+            : "memory", "cc" XMM0_CLOBBER
+        );
+    }
+    if((count = (n % SSE_BLOCK) / SSE_ALIGN) > 0) {
+        asm volatile ("                     \n\
+            movups  (%2), %%xmm0            \n\
+            1:                              \n\
+            movaps  %%xmm0, (%0)            \n\
+            addl    $16, %0                 \n\
+            decl    %1                      \n\
+            jnz     1b                      \n\
+            "
+            : "+r"(d), "+r"(count)
+            : "r"(pattern)
+            : "memory", "cc" XMM0_CLOBBER
+        );
+    }
+    restore_flags(flags);
+    memset_small(d, c, n % SSE_ALIGN);
+}
+
+/* void* memset(void* s, int32_t c, uint32_t n);
+ * Inputs:    void* s = pointer to memory
+ *          int32_t c = value to set memory to
+ *         uint32_t n = number of bytes to set
+ * Return Value: new string
+ * Function: set n consecutive bytes of pointer s to value c, with the
+ *           strategy mem_init picked for this size (see MEM_SMALL) */
+void* (memset)(void* s, int32_t c, uint32_t n) {
+    c &= 0xFF;
+    if(n <= MEM_SMALL)
+        memset_small(s, c, n);
+    else if(n >= MEM_LARGE && (mem_features & MEM_ERMS))
+        set_erms(s, c, n);
+    else if(mem_features & MEM_SSE)
+        set_sse(s, c, n);
+    else
+        set_stosl(s, c, n);
     return s;
 }
 
@@ -354,13 +581,13 @@ void* memset_dword(void* s, int32_t c, uint32_t n) {
     return s;
 }
 
-/* void* memcpy(void* dest, const void* src, uint32_t n);
+/* void copy_movsl(void* dest, const void* src, uint32_t n);
  * Inputs:      void* dest = destination of copy
  *         const void* src = source of copy
- *              uint32_t n = number of byets to copy
- * Return Value: pointer to dest
- * Function: copy n bytes of src to dest */
-void* memcpy(void* dest, const void* src, uint32_t n) {
+ *              uint32_t n = number of bytes to copy
+ * Return Value: none
+ * Function: aligns dest to 4 bytes, then rep movsl and a byte tail */
+static void copy_movsl(void* dest, const void* src, uint32_t n) {
     asm volatile ("                 \n\
             .memcpy_top:            \n\
             testl   %%ecx, %%ecx    \n\
@@ -392,10 +619,111 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
             jmp     .memcpy_bottom  \n\
             .memcpy_done:           \n\
             "
+            : "+S"(src), "+D"(dest), "+c"(n)
             :
-            : "S"(src), "D"(dest), "c"(n)
             : "eax", "edx", "memory", "cc"
     );
+}
+
+/* void copy_erms(void* dest, const void* src, uint32_t n);
+ * Inputs:      void* dest = destination of copy
+ *         const void* src = source of copy
+ *              uint32_t n = number of bytes to copy
+ * Return Value: none
+ * Function: rep movsb, which CPUs with ERMS run a cache line at a time */
+static void copy_erms(void* dest, const void* src, uint32_t n) {
+    asm volatile ("                 \n\
+            movw    %%ds, %%dx      \n\
+            movw    %%dx, %%es      \n\
+            cld                     \n\
+            rep     movsb           \n\
+            "
+            : "+D"(dest), "+S"(src), "+c"(n)
+            :
+            : "edx", "memory", "cc"
+    );
+}
+
+/* void copy_sse(void* dest, const void* src, uint32_t n);
+ * Inputs:      void* dest = destination of copy
+ *         const void* src = source of copy
+ *              uint32_t n = number of bytes to copy, at least SSE_ALIGN
+ * Return Value: none
+ * Function: aligns dest to 16 bytes and moves 64 bytes per iteration
+ *           through XMM0-3, loading src unaligned. Every block is loaded
+ *           before it is stored, so a dest below an overlapping src is
+ *           fine. Interrupts stay off while the XMM registers are in use,
+ *           they are not saved on a context switch. */
+static void copy_sse(void* dest, const void* src, uint32_t n) {
+    uint8_t* d = dest;
+    const uint8_t* s = src;
+    uint32_t head, count, flags;
+
+    head = -(uint32_t)d & (SSE_ALIGN - 1);
+    memcpy_small(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+
+    cli_and_save(flags);
+    if((count = n / SSE_BLOCK) > 0) {
+        asm volatile ("                     \n\
+            1:                              \n\
+            movups  (%1), %%xmm0            \n\
+            movups  16(%1), %%xmm1          \n\
+            movups  32(%1), %%xmm2          \n\
+            movups  48(%1), %%xmm3          \n\
+            movaps  %%xmm0, (%0)            \n\
+            movaps  %%xmm1, 16(%0)          \n\
+            movaps  %%xmm2, 32(%0)          \n\
+            movaps  %%xmm3, 48(%0)          \n\
+            addl    $64, %1                 \n\
+            addl    $64, %0                 \n\
+            decl    %2                      \n\
+            jnz     1b                      \n\
+            "
+            : "+r"(d), "+r"(s), "+r"(count)
+            :
+            : "memory", "cc" XMM0_3_CLOBBER
+        );
+    }
+    if((count = (n % SSE_BLOCK) / SSE_ALIGN) > 0) {
+        asm volatile ("                     \n\
+            1:                              \n\
+            movups  (%1), %%xmm0            \n\
+            movaps  %%xmm0, (%0)            \n\
+            addl    $16, %1                 \n\
+            addl    $16, %0                 \n\
+            decl    %2                      \n\
+            jnz     1b                      \n\
+            "
+            : "+r"(d), "+r"(s), "+r"(count)
+            :
+            : "memory", "cc" XMM0_CLOBBER
+        );
+    }
+    restore_flags(flags);
+    memcpy_small(d, s, n % SSE_ALIGN);
+}
+
+/* void* memcpy(void* dest, const void* src, uint32_t n);
+ * Inputs:      void* dest = destination of copy
+ *         const void* src = source of copy
+ *              uint32_t n = number of byets to copy
+ * Return Value: pointer to dest
+ * Function: copy n bytes of src to dest, with the strategy mem_init picked
+ *           for this size (see MEM_SMALL). Every strategy copies forward
+ *           and reads a byte before the byte below it is written, which
+ *           memmove relies on. */
+void* (memcpy)(void* dest, const void* src, uint32_t n) {
+    if(n <= MEM_SMALL)
+        memcpy_small(dest, src, n);
+    else if(n >= MEM_LARGE && (mem_features & MEM_ERMS))
+        copy_erms(dest, src, n);
+    else if(mem_features & MEM_SSE)
+        copy_sse(dest, src, n);
+    else
+        copy_movsl(dest, src, n);
     return dest;
 }
 
@@ -405,24 +733,31 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
  *         const void* src = source of move
  *              uint32_t n = number of byets to move
  * Return Value: pointer to dest
- * Function: move n bytes of src to dest */
+ * Function: move n bytes of src to dest. Only a dest that starts inside
+ *           src needs a backward copy, anything else goes to memcpy. */
 void* memmove(void* dest, const void* src, uint32_t n) {
-    asm volatile ("                             \n\
-            movw    %%ds, %%dx                  \n\
-            movw    %%dx, %%es                  \n\
-            cld                                 \n\
-            cmp     %%edi, %%esi                \n\
-            jae     .memmove_go                 \n\
-            leal    -1(%%esi, %%ecx), %%esi     \n\
-            leal    -1(%%edi, %%ecx), %%edi     \n\
-            std                                 \n\
-            .memmove_go:                        \n\
-            rep     movsb                       \n\
+    uint32_t tail = n & 0x3;
+    uint8_t* d = (uint8_t*)dest + n - 4;
+    const uint8_t* s = (const uint8_t*)src + n - 4;
+    uint32_t count = n >> 2;
+
+    if((uint32_t)dest - (uint32_t)src >= n)
+        return memcpy(dest, src, n);
+
+    // dwords from the end down, then the bytes below them
+    asm volatile ("                 \n\
+            movw    %%ds, %%dx      \n\
+            movw    %%dx, %%es      \n\
+            std                     \n\
+            rep     movsl           \n\
+            cld                     \n\
             "
+            : "+D"(d), "+S"(s), "+c"(count)
             :
-            : "D"(dest), "S"(src), "c"(n)
             : "edx", "memory", "cc"
     );
+    while(tail-- > 0)
+        ((uint8_t*)dest)[tail] = ((const uint8_t*)src)[tail];
     return dest;
 }
 
@@ -438,18 +773,22 @@ void* memmove(void* dest, const void* src, uint32_t n) {
  *               indicates the opposite.
  * Function: compares string 1 and string 2 for equality */
 int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n) {
-    int32_t i;
-    for (i = 0; i < n; i++) {
-        if ((s1[i] != s2[i]) || (s1[i] == '\0') /* || s2[i] == '\0' */) {
-
-            /* The s2[i] == '\0' is unnecessary because of the short-circuit
-             * semantics of 'if' expressions in C.  If the first expression
-             * (s1[i] != s2[i]) evaluates to false, that is, if s1[i] ==
-             * s2[i], then we only need to test either s1[i] or s2[i] for
-             * '\0', since we know they are equal. */
-            return s1[i] - s2[i];
+    uint32_t w;
+    // strings with the same alignment are compared a word at a time once
+    // aligned, until a word differs or holds the terminator
+    if((((uint32_t)s1 ^ (uint32_t)s2) & 0x3) == 0) {
+        for(; n > 0 && ((uint32_t)s1 & 0x3); --n, ++s1, ++s2)
+            if(*s1 != *s2 || *s1 == '\0')
+                return *s1 - *s2;
+        for(; n >= 4; n -= 4, s1 += 4, s2 += 4) {
+            w = *(const uint32_t*)s1;
+            if(w != *(const uint32_t*)s2 || HAS_ZERO(w))
+                break;
         }
     }
+    for(; n > 0; --n, ++s1, ++s2)
+        if(*s1 != *s2 || *s1 == '\0')
+            return *s1 - *s2;
     return 0;
 }
 
@@ -457,33 +796,39 @@ int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n) {
  * Inputs:      int8_t* dest = destination string of copy
  *         const int8_t* src = source string of copy
  * Return Value: pointer to dest
- * Function: copy the source string into the destination string */
+ * Function: copy the source string into the destination string, a word
+ *           at a time once src is aligned */
 int8_t* strcpy(int8_t* dest, const int8_t* src) {
-    int32_t i = 0;
-    while (src[i] != '\0') {
-        dest[i] = src[i];
-        i++;
-    }
-    dest[i] = '\0';
+    int8_t* d = dest;
+    for(; (uint32_t)src & 0x3; ++src, ++d)
+        if((*d = *src) == '\0')
+            return dest;
+    // whole words while none holds the terminator, dest may be unaligned
+    for(; !HAS_ZERO(*(const uint32_t*)src); src += 4, d += 4)
+        *(uint32_t*)d = *(const uint32_t*)src;
+    while((*d++ = *src++) != '\0');
     return dest;
 }
 
-/* int8_t* strcpy(int8_t* dest, const int8_t* src, uint32_t n)
+/* int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n)
  * Inputs:      int8_t* dest = destination string of copy
  *         const int8_t* src = source string of copy
  *                uint32_t n = number of bytes to copy
  * Return Value: pointer to dest
- * Function: copy n bytes of the source string into the destination string */
+ * Function: copy n bytes of the source string into the destination string,
+ *           a word at a time once src is aligned, and zero fill the rest */
 int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n) {
-    int32_t i = 0;
-    while (src[i] != '\0' && i < n) {
-        dest[i] = src[i];
-        i++;
-    }
-    while (i < n) {
-        dest[i] = '\0';
-        i++;
+    int8_t* d = dest;
+    for(; n > 0 && ((uint32_t)src & 0x3) && *src != '\0'; --n)
+        *d++ = *src++;
+    if(((uint32_t)src & 0x3) == 0) {
+        for(; n >= 4 && !HAS_ZERO(*(const uint32_t*)src); n -= 4, src += 4, d += 4)
+            *(uint32_t*)d = *(const uint32_t*)src;
     }
+    for(; n > 0 && *src != '\0'; --n)
+        *d++ = *src++;
+    // the rest of dest is zero filled
+    memset(d, 0, n);
     return dest;
 }
 
@@ -14,14 +14,19 @@
 
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
+void term_putc(int32_t tid, uint8_t c);
 int32_t puts(int8_t *s);
+int32_t putn(const uint8_t* buf, int32_t n);
+int32_t term_putn(int32_t tid, const uint8_t* buf, int32_t n);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
 int8_t *strrev(int8_t* s);
 uint32_t strlen(const int8_t* s);
 void clear(void);
+void term_clear(int32_t tid);
 void update_cursor(void);
 void test_interrupts(void);
 
+void mem_init(void);
 void* memset(void* s, int32_t c, uint32_t n);
 void* memset_word(void* s, int32_t c, uint32_t n);
 void* memset_dword(void* s, int32_t c, uint32_t n);
@@ -79,6 +84,114 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Reads the low 32 bits of the time-stamp counter. Used for cycle counts
+ * in benchmarks, so only short intervals should be measured with it */
+static inline uint32_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile ("rdtsc"
+            : "=a"(lo), "=d"(hi)
+    );
+    return lo;
+}
+
+/* Writes a model specific register */
+static inline void wrmsr(uint32_t msr, uint32_t lo, uint32_t hi) {
+    asm volatile ("wrmsr"
+            :
+            : "c"(msr), "a"(lo), "d"(hi)
+    );
+}
+
+/* Runs CPUID for a leaf, returns EDX and stores the other registers if
+ * the pointers are not NULL */
+static inline uint32_t cpuid(uint32_t leaf, uint32_t* a, uint32_t* b, uint32_t* c) {
+    uint32_t eax, ebx, ecx, edx;
+    asm volatile ("cpuid"
+            : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+            : "a"(leaf), "c"(0)
+    );
+    if(a != NULL) *a = eax;
+    if(b != NULL) *b = ebx;
+    if(c != NULL) *c = ecx;
+    return edx;
+}
+
+/* CPUID leaves and the feature bits memcpy and memset look for */
+#define CPUID_FEATURES          1
+#define CPUID_EXT_FEATURES      7
+#define CPUID_EDX_SSE           0x02000000
+#define CPUID_EDX_SSE2          0x04000000
+#define CPUID_EBX_ERMS          0x00000200
+
+/* CR0 and CR4 bits that let the kernel use the XMM registers */
+#define CR0_MP                  0x02
+#define CR0_EM                  0x04
+#define CR4_OSFXSR              0x200
+#define CR4_OSXMMEXCPT          0x400
+
+/* memcpy and memset pick a strategy by size. Up to MEM_SMALL bytes are
+ * moved a word at a time, from MEM_LARGE on rep movsb/stosb is used if the
+ * CPU has enhanced rep strings (ERMS), everything else goes through 16
+ * byte SSE loads and stores if the CPU has SSE, rep movsl/stosl otherwise */
+#define MEM_SMALL               16
+#define MEM_LARGE               1024
+#define SSE_ALIGN               16
+#define SSE_BLOCK               64
+#define MEM_SSE                 0x1
+#define MEM_ERMS                0x2
+// SSE2 byte compares, used for file names (see dentry_name_eq)
+#define MEM_SSE2                0x4
+
+/* XMM registers clobbered by the SSE asm. gcc only takes them in a clobber
+ * list when it may use SSE itself (-msse), and without that it never keeps
+ * anything in them, so there is nothing to declare */
+#ifdef __SSE__
+#define XMM0_CLOBBER            , "xmm0"
+#define XMM0_3_CLOBBER          , "xmm0", "xmm1", "xmm2", "xmm3"
+#else
+#define XMM0_CLOBBER
+#define XMM0_3_CLOBBER
+#endif
+
+/* nonzero if a 32 bit word has a zero byte: subtracting 1 from every byte
+ * only borrows into a byte's top bit if the byte was 0 (or had it set,
+ * which ~w rules out). String functions use it to scan a word at a time. */
+#define ONE_BYTES               0x01010101
+#define HIGH_BYTES              0x80808080
+#define HAS_ZERO(w)             (((w) - ONE_BYTES) & ~(w) & HIGH_BYTES)
+
+/* strategies mem_init found, tests may clear bits to compare them */
+extern uint32_t mem_features;
+
+/* Copies a few bytes a word at a time, what memcpy does with small sizes.
+ * Always inlined so copies of a constant size skip memcpy altogether. */
+static inline __attribute__((always_inline)) void* memcpy_small(void* dest, const void* src, uint32_t n) {
+    uint8_t* d = dest;
+    const uint8_t* s = src;
+    for(; n >= 4; n -= 4, d += 4, s += 4)
+        *(uint32_t*)d = *(const uint32_t*)s;
+    for(; n > 0; --n)
+        *d++ = *s++;
+    return dest;
+}
+
+/* memset counterpart of memcpy_small */
+static inline __attribute__((always_inline)) void* memset_small(void* s, int32_t c, uint32_t n) {
+    uint8_t* d = s;
+    uint32_t w = (c & 0xFF) * 0x01010101;
+    for(; n >= 4; n -= 4, d += 4)
+        *(uint32_t*)d = w;
+    for(; n > 0; --n)
+        *d++ = (uint8_t)c;
+    return s;
+}
+
+/* small constant sizes (struct fields, page table entries) are copied inline */
+#define memcpy(dest, src, n)    \
+    (__builtin_constant_p(n) && (n) <= MEM_SMALL ? memcpy_small(dest, src, n) : memcpy(dest, src, n))
+#define memset(s, c, n)         \
+    (__builtin_constant_p(n) && (n) <= MEM_SMALL ? memset_small(s, c, n) : memset(s, c, n))
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
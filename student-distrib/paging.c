@@ -1,9 +1,27 @@
 #include "paging.h"
+#include "frame.h"
+
+uint32_t exec_pages_faulted;
+uint32_t exec_pages_total;
+uint32_t cow_pages_copied;
+uint32_t exec_pages_shared;
+
+// pages of recently executed program images. The cache holds one reference
+// on every frame in it, each process mapping the page holds another.
+typedef struct img_cache {
+    int32_t inode;              // NO_INODE if the slot is free
+    uint32_t last_use;          // img_clock when a page was last taken
+    uint32_t frames[IMG_CACHE_PAGES]; // 0 while the page is not loaded
+} img_cache_t;
+
+static img_cache_t img_cache[IMG_CACHE_SLOTS];
+static uint32_t img_clock;
 
 /* paging_init - CP1
  * Initializes and enables paging. This includes the 4KB video memory inside
  * the first 4MB page, the 4MB Kernal page, as well as 1022 "not present"
- * 4MB pages.
+ * 4MB pages. Kernel and video mappings are the same in every address space
+ * and are marked global, so CR3 reloads keep them in the TLB.
  * parameter - none
  * return - none
  */
@@ -13,20 +31,22 @@ void paging_init(void) {
         page_dir[i] = RW;
         page_table[i] = i * _4_KB | RW;
     }
-    // 4KB page mapped to physical video memory
-    page_table[VID_MEM_IDX] |= RW | PR;
-    // preceding 3 pages reserved for terminal buffers
-    page_table[TERM0_BUFF] |= RW | PR;
-    page_table[TERM1_BUFF] |= RW | PR;
-    page_table[TERM2_BUFF] |= RW | PR;
+    // each terminal owns one 4KB page of the 32KB text mode window
+    for (i = 0; i < TERMINAL_COUNT; ++i)
+        page_table[VID_MEM_IDX + i] |= GLOBAL | RW | PR;
     // first page is reserved for video and buffers
     page_dir[K_VIDEO_IDX] = ((uint32_t)page_table) | RW | PR;
     // second page is reserved for 4MB Kernel page
-    page_dir[KERNEL_IDX] = _4_MB | PAGE_4MB | RW | PR;
+    page_dir[KERNEL_IDX] = _4_MB | PAGE_4MB | GLOBAL | RW | PR;
+    // the rest of RAM (below the user windows) is mapped 1:1 for the kernel
+    // so it can fill frames from the frame allocator
+    for (i = DIRECT_IDX; i < frame_top / _4_MB; ++i)
+        page_dir[i] = (i * _4_MB) | PAGE_4MB | GLOBAL | RW | PR;
 
     // - set CR3 using address of page_directory,
     // - set CR4.PSE bit (to enable 4MB pages)
     // - set CR0.PG bit, CR0.PE bit?
+    // - set CR0.WP so the kernel's writes to copy-on-write pages fault too
     asm volatile("                                               \n\
         movl $page_dir, %%eax                                     \n\
         movl %%eax, %%cr3                                         \n\
@@ -34,42 +54,657 @@ void paging_init(void) {
         orl  $0x00000010, %%eax                                   \n\
         movl %%eax, %%cr4                                         \n\
         movl %%cr0, %%eax                                         \n\
-        orl  $0x80000001, %%eax                                   \n\
+        orl  $0x80010001, %%eax                                   \n\
         movl %%eax, %%cr0"                                        \
         :                                                         \
         : "g"(page_dir)                                           \
         : "eax");
+    // global pages can only be enabled once paging is on
+    set_global_pages(1);
+
+    for (i = 0; i < IMG_CACHE_SLOTS; ++i)
+        img_cache[i].inode = NO_INODE;
+}
+
+/* set_global_pages - CP5
+ * Sets or clears CR4.PGE. While it is clear global entries are flushed by
+ * CR3 reloads like any other, and clearing it flushes the whole TLB.
+ * parameter - enable : 1 to keep global pages across CR3 reloads
+ * return - none
+ */
+void set_global_pages(int32_t enable) {
+    uint32_t cr4;
+    asm volatile("movl %%cr4, %0" : "=r"(cr4));
+    if(enable)
+        cr4 |= CR4_PGE;
+    else
+        cr4 &= ~CR4_PGE;
+    asm volatile("movl %0, %%cr4" : : "r"(cr4) : "memory");
 }
 
 /* map_program - CP3
- * Maps the program that is currently running to the correct process given
- * by the process number.
- * parameter - pid : pid is between 0 - 5, thus we point at
- *                   8MB, 12MB, ... and so on depending on the process.
+ * Switches to the page directory of a process. User mappings live only in
+ * that directory, the kernel ones are shared and global, so only the
+ * process' own entries leave the TLB. A process that has not executed yet
+ * runs on the kernel's directory.
+ * parameter - pid : process whose page directory is installed
  * return - none
  */
 void map_program(uint32_t pid) {
-    uint32_t addr = _8_MB + _4_MB * pid;
-    page_dir[PROGRAM_IDX] = addr | PAGE_4MB | USR | RW | PR;
+    pcb_t* pcb = get_pcb(pid);
+    load_page_dir(pcb->page_dir != NULL ? pcb->page_dir : page_dir);
+}
+
+/* free_pages
+ * Gives every present page of a page table back to the frame allocator
+ * parameter - table : program page table
+ * return - none
+ */
+static void free_pages(uint32_t* table) {
+    int i;
+    for(i = 0; i < _1_KB; ++i) {
+        if(table[i] & PR)
+            frame_free(table[i] & ~(_4_KB - 1));
+        table[i] = 0;
+    }
+}
+
+/* alloc_table
+ * Takes a zeroed frame for a page table or page directory
+ * parameter - none
+ * return - the table, NULL if memory is exhausted
+ */
+static uint32_t* alloc_table(void) {
+    uint32_t* table = (uint32_t*)frame_alloc();
+    if(table != NULL)
+        memset(table, 0, _4_KB);
+    return table;
+}
+
+/* release_vid_table
+ * Empties the page table of the vidmap and ring pages, the ring's frame is
+ * freed
+ * parameter - pcb : process with a vid_table
+ * return - none
+ */
+static void release_vid_table(pcb_t* pcb) {
+    if(pcb->ring != NULL) {
+        frame_free((uint32_t)pcb->ring);
+        pcb->ring = NULL;
+    }
+    memset(pcb->vid_table, 0, _4_KB);
+}
+
+/* reset_program - CP5
+ * Gives a process an empty address space: its own page directory with the
+ * kernel's entries, and a program window whose pages are not present and
+ * have no frame yet, page_in allocates them when touched. vidmap and mmap
+ * mappings, anonymous memory and the system call ring of a previous
+ * program are dropped. The directory and window
+ * page table come from the frame allocator the first time.
+ * parameter - pid : process whose window is reset
+ * return - 0 on success, -1 if there is no memory for the tables
+ */
+int32_t reset_program(uint32_t pid) {
+    pcb_t* pcb = get_pcb(pid);
+    if(pcb->page_dir == NULL) {
+        if((pcb->page_dir = alloc_table()) == NULL)
+            return -1;
+        if((pcb->prog_table = alloc_table()) == NULL) {
+            frame_free((uint32_t)pcb->page_dir);
+            pcb->page_dir = NULL;
+            return -1;
+        }
+    } else
+        free_pages(pcb->prog_table);
+    if(pcb->anon_table != NULL)
+        free_pages(pcb->anon_table);
+    if(pcb->vid_table != NULL)
+        release_vid_table(pcb);
+    pcb->user_pages = 0;
+
+    // kernel entries never change after paging_init, everything else is
+    // the process' own
+    memcpy(pcb->page_dir, page_dir, _4_KB);
+    pcb->page_dir[PROGRAM_IDX] = (uint32_t)pcb->prog_table | USR | RW | PR;
+    pcb->page_dir[U_VIDEO_IDX] = RW;
+    pcb->page_dir[FMAP_IDX] = RW;
+    pcb->page_dir[ANON_IDX] = RW;
+    return 0;
+}
+
+/* release_program - CP5
+ * Gives the frames of a finished process' window and its page tables and
+ * directory back. The process must not be mapped anymore.
+ * parameter - pid : process that halted
+ * return - none
+ */
+void release_program(uint32_t pid) {
+    pcb_t* pcb = get_pcb(pid);
+    if(pcb->prog_table != NULL) {
+        free_pages(pcb->prog_table);
+        frame_free((uint32_t)pcb->prog_table);
+        pcb->prog_table = NULL;
+    }
+    if(pcb->fmap_table != NULL) {
+        frame_free((uint32_t)pcb->fmap_table);
+        pcb->fmap_table = NULL;
+    }
+    if(pcb->vid_table != NULL) {
+        release_vid_table(pcb);
+        frame_free((uint32_t)pcb->vid_table);
+        pcb->vid_table = NULL;
+    }
+    if(pcb->anon_table != NULL) {
+        free_pages(pcb->anon_table);
+        frame_free((uint32_t)pcb->anon_table);
+        pcb->anon_table = NULL;
+    }
+    if(pcb->page_dir != NULL) {
+        frame_free((uint32_t)pcb->page_dir);
+        pcb->page_dir = NULL;
+    }
+}
+
+/* share_pages
+ * Makes a child's page table map the same frames as its parent's, writable
+ * pages become copy-on-write on both sides except shared memory segments.
+ * Reserved anonymous pages that were never touched stay reserved.
+ * parameter - parent : parent's page table
+ *             child : child's empty page table
+ * return - none
+ */
+static void share_pages(uint32_t* parent, uint32_t* child) {
+    int i;
+    for(i = 0; i < _1_KB; ++i) {
+        if(parent[i] & PR) {
+            if((parent[i] & RW) && !(parent[i] & SHARED))
+                parent[i] = (parent[i] & ~RW) | COW;
+            frame_share(parent[i] & ~(_4_KB - 1));
+        }
+        child[i] = parent[i];
+    }
+}
+
+/* user_pte
+ * Finds the page table entry of an address in a process' demand paged
+ * windows, the program window and the anonymous memory window
+ * parameter - pcb : process
+ *             addr : user virtual address
+ * return - the entry, NULL if addr is in neither window
+ */
+static uint32_t* user_pte(pcb_t* pcb, uint32_t addr) {
+    if(addr >= _128_MB && addr < _132_MB && pcb->prog_table != NULL)
+        return &pcb->prog_table[(addr - _128_MB) / _4_KB];
+    if(addr >= _148_MB && addr < _148_MB + _4_MB && pcb->anon_table != NULL)
+        return &pcb->anon_table[(addr - _148_MB) / _4_KB];
+    return NULL;
+}
+
+/* fork_program - CP5
+ * Gives a forked child an address space built from its parent's. Program
+ * and anonymous pages are not copied: both sides map the same frames read-only with the
+ * COW bit and cow_fault copies a page when either writes it. The file window
+ * and vidmap page tables are copied, what they map is read-only or shared
+ * anyway, except the system call ring which is copied. The parent must be the running process.
+ * parameter - parent_pid : process calling fork
+ *             child_pid : its new child
+ * return - 0 on success, -1 if there is no memory for the tables
+ */
+int32_t fork_program(uint32_t parent_pid, uint32_t child_pid) {
+    pcb_t* parent = get_pcb(parent_pid);
+    pcb_t* child = get_pcb(child_pid);
+
+    if(parent->page_dir == NULL || reset_program(child_pid) == -1)
+        return -1;
+    if(parent->page_dir[FMAP_IDX] & PR) {
+        if(child->fmap_table == NULL && (child->fmap_table = alloc_table()) == NULL)
+            goto fail;
+        memcpy(child->fmap_table, parent->fmap_table, _4_KB);
+        child->page_dir[FMAP_IDX] = (uint32_t)child->fmap_table | USR | PR;
+    }
+    if(parent->page_dir[U_VIDEO_IDX] & PR) {
+        if(child->vid_table == NULL && (child->vid_table = alloc_table()) == NULL)
+            goto fail;
+        child->vid_table[0] = parent->vid_table[0];
+        // the ring is the process' own, the child gets a copy
+        if(parent->ring != NULL) {
+            if((child->ring = (syscall_ring_t*)frame_alloc()) == NULL)
+                goto fail;
+            memcpy(child->ring, parent->ring, _4_KB);
+            child->vid_table[RING_PAGE] = (uint32_t)child->ring | USR | RW | PR;
+        }
+        child->page_dir[U_VIDEO_IDX] = (uint32_t)child->vid_table | USR | RW | PR;
+    }
+
+    if(parent->anon_table != NULL) {
+        if(child->anon_table == NULL && (child->anon_table = alloc_table()) == NULL)
+            goto fail;
+        share_pages(parent->anon_table, child->anon_table);
+        child->page_dir[ANON_IDX] = (uint32_t)child->anon_table | USR | RW | PR;
+    }
+    share_pages(parent->prog_table, child->prog_table);
+    child->user_pages = parent->user_pages;
+    // the parent's pages just lost write access
+    flush();
+    return 0;
+
+fail:
+    release_program(child_pid);
+    return -1;
+}
+
+/* cow_fault - CP5
+ * Handles a write to a copy-on-write page of the program or anonymous
+ * memory window. A frame
+ * still shared is copied into a new one, the last owner just gets write
+ * access back.
+ * parameter - addr : faulting address (CR2)
+ * return - 0 if the page is writable now, -1 if this is not a COW page or
+ *          memory is exhausted
+ */
+int32_t cow_fault(uint32_t addr) {
+    uint32_t* pte;
+    uint32_t old, frame;
+
+    if(cur_pid < 0 || (pte = user_pte(get_pcb(cur_pid), addr)) == NULL)
+        return -1;
+    if((*pte & (COW | PR)) != (COW | PR))
+        return -1;
+
+    old = *pte & ~(_4_KB - 1);
+    frame = old;
+    if(frame_shared(old)) {
+        if((frame = frame_alloc()) == 0)
+            return -1;
+        // frames are mapped 1:1 in the kernel
+        memcpy((void*)frame, (void*)old, _4_KB);
+        frame_free(old);
+        cow_pages_copied++;
+    }
+    *pte = frame | USR | RW | PR;
+    invlpg(addr & ~(_4_KB - 1));
+    return 0;
+}
+
+/* anon_window
+ * Makes sure a process has a page table for its anonymous memory window
+ * parameter - pcb : process
+ * return - 0 on success, -1 if there is no memory for the table
+ */
+static int32_t anon_window(pcb_t* pcb) {
+    if(pcb->page_dir == NULL)
+        return -1;
+    if(pcb->anon_table == NULL && (pcb->anon_table = alloc_table()) == NULL)
+        return -1;
+    pcb->page_dir[ANON_IDX] = (uint32_t)pcb->anon_table | USR | RW | PR;
+    return 0;
+}
+
+/* anon_fit
+ * Finds the first run of free pages in a process' anonymous memory window
+ * parameter - pcb : process with an anonymous memory window
+ *             pages : length of the run
+ * return - index of the run's first page, -1 if there is none
+ */
+static int32_t anon_fit(pcb_t* pcb, uint32_t pages) {
+    uint32_t i, run;
+    for(i = 0, run = 0; i < _1_KB; ++i) {
+        run = pcb->anon_table[i] ? 0 : run + 1;
+        if(run == pages)
+            return i + 1 - pages;
+    }
+    return -1;
+}
+
+/* map_anon - CP5
+ * Reserves a run of pages in a process' anonymous memory window, first fit.
+ * The pages get zero filled frames when touched (see page_in).
+ * parameter - pid : process asking for memory
+ *             pages : number of pages
+ * return - address of the first page, 0 if the window has no room or there
+ *          is no memory for its page table
+ */
+uint32_t map_anon(uint32_t pid, uint32_t pages) {
+    pcb_t* pcb = get_pcb(pid);
+    int32_t first;
+    uint32_t i;
+
+    if(pages == 0 || pages > _1_KB || anon_window(pcb) == -1)
+        return 0;
+    if((first = anon_fit(pcb, pages)) == -1)
+        return 0;
+    for(i = 0; i < pages; ++i)
+        pcb->anon_table[first + i] = ANON_RESERVED;
+    return _148_MB + first * _4_KB;
+}
+
+/* map_shared - CP5
+ * Maps the frames of a shared memory segment into a process' anonymous
+ * memory window, writable and with one more reference each, so a segment
+ * mapped twice is the same memory at both addresses. The mapping goes at
+ * addr if the caller picked one, first fit otherwise, and munmap removes it
+ * like anonymous memory.
+ * parameter - pid : process to map into
+ *             addr : page aligned address in the window, 0 for any
+ *             frames : the segment's frames
+ *             pages : number of frames to map
+ * return - address of the mapping, 0 if the range is taken or out of the
+ *          window
+ */
+uint32_t map_shared(uint32_t pid, uint32_t addr, const uint32_t* frames, uint32_t pages) {
+    pcb_t* pcb = get_pcb(pid);
+    int32_t first;
+    uint32_t i;
+
+    if(pages == 0 || pages > _1_KB || anon_window(pcb) == -1)
+        return 0;
+    if(addr == 0) {
+        if((first = anon_fit(pcb, pages)) == -1)
+            return 0;
+    } else {
+        if((addr & (_4_KB - 1)) || addr < _148_MB || addr >= _148_MB + _4_MB)
+            return 0;
+        first = (addr - _148_MB) / _4_KB;
+        if(first + pages > _1_KB)
+            return 0;
+        for(i = 0; i < pages; ++i)
+            if(pcb->anon_table[first + i])
+                return 0;
+    }
+    // the pages were not present, nothing to flush
+    for(i = 0; i < pages; ++i) {
+        frame_share(frames[i]);
+        pcb->anon_table[first + i] = frames[i] | SHARED | USR | RW | PR;
+    }
+    pcb->user_pages += pages;
+    return _148_MB + first * _4_KB;
+}
+
+/* unmap_user - CP5
+ * Frees the pages starting in [start, end) of the program or anonymous
+ * memory window, for a heap that shrank or memory that was unmapped.
+ * Anonymous pages stop being reserved.
+ * parameter - pid : running process
+ *             start : page aligned start
+ *             end : end of the range, clamped to the end of start's window
+ * return - none
+ */
+void unmap_user(uint32_t pid, uint32_t start, uint32_t end) {
+    pcb_t* pcb = get_pcb(pid);
+    uint32_t* pte;
+    uint32_t win_end;
+
+    /* stay inside the window start is in so the loop cannot wrap */
+    if(start >= _128_MB && start < _132_MB)
+        win_end = _132_MB;
+    else if(start >= _148_MB && start < _148_MB + _4_MB)
+        win_end = _148_MB + _4_MB;
+    else
+        return;
+    if(end > win_end)
+        end = win_end;
+    for(; start < end; start += _4_KB) {
+        if((pte = user_pte(pcb, start)) == NULL)
+            continue;
+        if(*pte & PR) {
+            frame_free(*pte & ~(_4_KB - 1));
+            pcb->user_pages--;
+            invlpg(start);
+        }
+        *pte = 0;
+    }
+}
+
+/* img_cache_evict
+ * Drops the cache's reference on every page of a slot, pages still mapped
+ * by a process stay with it
+ * parameter - slot : slot to empty
+ * return - none
+ */
+static void img_cache_evict(img_cache_t* slot) {
+    int i;
+    for(i = 0; i < IMG_CACHE_PAGES; ++i) {
+        if(slot->frames[i] != 0)
+            frame_free(slot->frames[i]);
+        slot->frames[i] = 0;
+    }
+    slot->inode = NO_INODE;
+}
+
+/* img_cache_shrink - CP5
+ * Empties the least recently used slot of the image cache, used when
+ * memory runs out
+ * parameter - none
+ * return - 0 if a slot was emptied, -1 if the cache is empty
+ */
+int32_t img_cache_shrink(void) {
+    img_cache_t* lru = NULL;
+    int i;
+    for(i = 0; i < IMG_CACHE_SLOTS; ++i) {
+        if(img_cache[i].inode == NO_INODE || img_cache[i].last_use == 0)
+            continue;
+        if(lru == NULL || img_cache[i].last_use < lru->last_use)
+            lru = &img_cache[i];
+    }
+    if(lru == NULL)
+        return -1;
+    img_cache_evict(lru);
+    return 0;
+}
+
+/* img_cache_page - CP5
+ * Finds a page of a program image in the cache, reading it from the file
+ * system on a miss. The image's slot is taken on first use, evicting the
+ * least recently used image if every slot is busy. The file system is
+ * read-only, so a cached page never goes stale.
+ * parameter - inode : inode of the program file
+ *             offset : page aligned offset into the file
+ * return - frame with a reference taken for the caller, 0 if memory is
+ *          exhausted
+ */
+uint32_t img_cache_page(uint32_t inode, uint32_t offset) {
+    img_cache_t* slot = NULL;
+    uint32_t frame, idx = offset / _4_KB;
+    int32_t count;
+    int i;
+
+    if(idx >= IMG_CACHE_PAGES)
+        return 0;
+    for(i = 0; i < IMG_CACHE_SLOTS; ++i) {
+        if(img_cache[i].inode == (int32_t)inode) {
+            slot = &img_cache[i];
+            break;
+        }
+        if(img_cache[i].inode == NO_INODE && slot == NULL)
+            slot = &img_cache[i];
+    }
+    if(slot == NULL) {
+        // every slot holds another image, the oldest one goes
+        slot = &img_cache[0];
+        for(i = 1; i < IMG_CACHE_SLOTS; ++i)
+            if(img_cache[i].last_use < slot->last_use)
+                slot = &img_cache[i];
+        img_cache_evict(slot);
+    }
+    if(slot->inode != (int32_t)inode) {
+        slot->inode = inode;
+        memset(slot->frames, 0, sizeof(slot->frames));
+    }
+    // keeps the slot from being evicted while the frame is found below
+    slot->last_use = 0;
+
+    if((frame = slot->frames[idx]) == 0) {
+        while((frame = frame_alloc()) == 0)
+            if(img_cache_shrink() == -1)
+                break;
+        if(frame == 0) {
+            slot->last_use = ++img_clock;
+            return 0;
+        }
+        // frames are mapped 1:1 in the kernel
+        count = read_data(inode, offset, (uint8_t*)frame, _4_KB);
+        if(count < 0) count = 0;
+        memset((uint8_t*)frame + count, 0, _4_KB - count);
+        slot->frames[idx] = frame;
+        exec_pages_faulted++;
+    } else
+        exec_pages_shared++;
+    slot->last_use = ++img_clock;
+
+    frame_share(frame);
+    return frame;
+}
+
+/* page_in - CP5
+ * Services a not present fault in the running program's window. Pages that
+ * overlap the image map the image cache's frame copy-on-write, so every
+ * process running the same program shares one copy until it writes the
+ * page. The stack below the image, the heap up to the break and reserved
+ * anonymous pages get a new zero filled frame, anything else is invalid.
+ * parameter - addr : faulting virtual address
+ * return - 0 if the page was loaded, -1 if addr is not in the window or
+ *          memory is exhausted
+ */
+int32_t page_in(uint32_t addr) {
+    uint32_t page, frame;
+    uint32_t* pte;
+    int32_t pid = cur_pid;
+    pcb_t* pcb;
+
+    if(pid < 0) return -1;
+    pcb = get_pcb(pid);
+    if((pte = user_pte(pcb, addr)) == NULL || (*pte & PR)) return -1;
+    page = addr & ~(_4_KB - 1);
+
+    if(page < _132_MB) {
+        // image pages come from the image cache, shared copy-on-write
+        if(page >= PROG_IMG_ADDR && page - PROG_IMG_ADDR < pcb->img_length) {
+            if((frame = img_cache_page(pcb->img_inode, page - PROG_IMG_ADDR)) == 0)
+                return -1;
+            // page is not cached in the TLB while not present, no flush needed
+            *pte = frame | USR | COW | PR;
+            pcb->user_pages++;
+            pcb->img_pages++;
+            return 0;
+        }
+        // above the image only the heap (bss included) is valid
+        if(page >= PROG_IMG_ADDR && page >= pcb->brk)
+            return -1;
+    } else if(!(*pte & ANON_RESERVED))
+        return -1;
+
+    while((frame = frame_alloc()) == 0)
+        if(img_cache_shrink() == -1)
+            return -1;
+    *pte = frame | USR | RW | PR;
+    pcb->user_pages++;
+    memset((uint8_t*)page, 0, _4_KB);
+    return 0;
+}
+
+/* map_file - CP5
+ * Maps the data blocks of a file read-only into the file window at 144MB.
+ * Blocks do not need to be contiguous in data_arr since each one gets its
+ * own 4KB page, but the filesystem module has to be page aligned (multiboot
+ * header asks for this) so a block can be mapped without copying.
+ * parameter - pid : process to map into
+ *             inode : inode # of file to map
+ * return - 0 on success, -1 if the file can not be mapped
+ */
+int32_t map_file(uint32_t pid, uint32_t inode) {
+    uint32_t i, num_blocks;
+    inode_t* inode_blk;
+    uint32_t* fmap_table;
+    pcb_t* pcb = get_pcb(pid);
+    if(inode >= boot->num_of_inodes || ((uint32_t)data_arr & (_4_KB - 1))) return -1;
+
+    inode_blk = &(inode_arr[inode]);
+    num_blocks = (inode_blk->length + _4_KB - 1) / _4_KB;
+    if(num_blocks > MAX_INODE_BLOCK) return -1; // more blocks than an inode holds
+    // check every block first, the old mapping stays intact on failure
+    for(i = 0; i < num_blocks; ++i)
+        if(inode_blk->dblk[i] >= boot->num_of_dblks) return -1; // bad block
+    if(pcb->fmap_table == NULL && (pcb->fmap_table = (uint32_t*)frame_alloc()) == NULL)
+        return -1;
+    fmap_table = pcb->fmap_table;
+
+    for(i = 0; i < num_blocks; ++i) {
+        // read-only user page directly on top of the data block
+        fmap_table[i] = (uint32_t)&(data_arr[inode_blk->dblk[i]]) | USR | PR;
+    }
+    for(; i < _1_KB; ++i)
+        fmap_table[i] = 0;
+
+    pcb->page_dir[FMAP_IDX] = (uint32_t)fmap_table | USR | PR;
+    flush();
+    return 0;
+}
+
+/* unmap_file - CP5
+ * Removes the file window of a process.
+ * parameter - pid : process to unmap
+ * return - none
+ */
+void unmap_file(uint32_t pid) {
+    get_pcb(pid)->page_dir[FMAP_IDX] = RW;
     flush();
 }
 
 /* map_video - CP4
- * maps video memory page in virtual address
+ * maps video memory page in virtual address. A process gets the video page
+ * of its own terminal through a page table of its own directory. Without a
+ * process (kernel tests) the page goes into the kernel's directory.
  * parameter - void
- * return - none
+ * return - 0 on success, -1 if there is no memory for the page table
+ */
+int32_t map_video(void){
+    pcb_t* pcb;
+    if(cur_pid < 0 || (pcb = get_pcb(cur_pid))->page_dir == NULL) {
+        page_dir[U_VIDEO_IDX] = (uint32_t)page_table | USR | RW | PR;
+        page_table[0] = (uint32_t)term_video(t_cur) | USR | RW | PR;
+        // page_table[0] is seen at 140MB and at 0, only those two can be stale
+        invlpg(_140_MB);
+        invlpg(0);
+        return 0;
+    }
+    if(pcb->vid_table == NULL && (pcb->vid_table = alloc_table()) == NULL)
+        return -1;
+    pcb->vid_table[0] = (uint32_t)term_video(pcb->tid) | USR | RW | PR;
+    pcb->page_dir[U_VIDEO_IDX] = (uint32_t)pcb->vid_table | USR | RW | PR;
+    invlpg(_140_MB);
+    return 0;
+}
+
+/* map_ring - CP5
+ * Maps a zeroed page for the system call ring at RING_ADDR, through the
+ * same page table as the vidmap page. A process that has a ring keeps it.
+ * parameter - pid : running process
+ * return - 0 on success, -1 if there is no memory
  */
-void map_video(void){
-    page_dir[U_VIDEO_IDX] = (uint32_t)page_table | USR | RW | PR;
-    page_table[0] = (uint32_t)VID_MEM | USR | RW | PR;
+int32_t map_ring(uint32_t pid) {
+    pcb_t* pcb = get_pcb(pid);
+    if(pcb->page_dir == NULL)
+        return -1;
+    if(pcb->ring != NULL)
+        return 0;
+    if(pcb->vid_table == NULL && (pcb->vid_table = alloc_table()) == NULL)
+        return -1;
+    if((pcb->ring = (syscall_ring_t*)alloc_table()) == NULL)
+        return -1;
+    pcb->vid_table[RING_PAGE] = (uint32_t)pcb->ring | USR | RW | PR;
+    pcb->page_dir[U_VIDEO_IDX] = (uint32_t)pcb->vid_table | USR | RW | PR;
+    invlpg(RING_ADDR);
+    return 0;
 }
 
 /* switch_display - CP5
- * Switches visible terminal from one to the other. First copies contents of
- * current video memory to the correct terminal video buffer,  and then
- * esp for process switching out of, and restores ebp and esp for process
- * we switch into. 
- * parameter - tid : terminal number to display to screen. Saves ebp and 
+ * Switches visible terminal from one to the other. Every terminal draws
+ * into its own page of text mode video memory all the time, so this only
+ * points the VGA display start (and the cursor) at the new terminal's page,
+ * nothing is copied. Processes keep running in every terminal, the
+ * scheduler decides who is on the CPU.
+ * parameter - tid : terminal number to display to screen.
  * return - none
  * side-effect - global t_visible is changed to new visible terminal.
  */
@@ -77,47 +712,25 @@ void switch_display(int32_t tid) {
     // sanity check
     if (tid < 0 || tid > (TERMINAL_COUNT-1) || tid == t_visible) 
         return;
-    
-    int32_t prev_tid = t_visible;
 
-    // save for process switch
-    pcb_t *pcb = get_pcb(t[prev_tid].running_process); //old
-    asm volatile(
-        "movl %%esp, %0     \n"
-        "movl %%ebp, %1     \n"
-        :"=r"(pcb->cur_esp), "=r"(pcb->cur_ebp) // output
-        : // input
-    );
-
-    memcpy((uint8_t*)(t[t_visible].video_mem), (uint8_t*)VID_MEM, _4_KB);
-    // update t_visible to next process
     t_visible = tid;
-    // copy next background buffer into VID_MEM so we can display
-    memcpy((uint8_t*)VID_MEM, (uint8_t*)t[t_visible].video_mem, _4_KB);
+    set_display_start(tid);
     update_cursor();
+}
 
-    if(t[prev_tid].shell_flag == 0 && t[t_visible].shell_flag == 0)  {
-        pcb_t *n_pcb = get_pcb(t[t_visible].running_process);  // new
-
-        tss.ss0 = KERNEL_DS;
-        tss.esp0 = _8_MB - _8_KB * n_pcb->pid - FOUR_BYTE;
-
-        // remap + flush TLB 
-        map_program(n_pcb->pid);
 
-        // restore for process switch
-        asm volatile(
-            "movl %0, %%esp\n\
-            movl %1, %%ebp"
-            : //ouput
-            :"r"(n_pcb->cur_esp), "r"(n_pcb->cur_ebp) //input
-        );
-    }
+/* load_page_dir - CP5
+ * Loads CR3 with a page directory, flushing every non-global TLB entry
+ * parameter - dir : page directory, 4KB aligned
+ * return - none
+ */
+void load_page_dir(uint32_t* dir) {
+    asm volatile("movl %0, %%cr3" : : "r"(dir) : "memory");
 }
 
-
 /* flush - CP2
- * Flushes TLB when altering paging
+ * Flushes TLB when altering paging. Global (kernel and video) entries
+ * survive, single changed entries should use invlpg instead.
  * parameter - none
  * return - none
  */
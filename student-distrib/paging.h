@@ -26,35 +26,102 @@
 #include "terminal.h"
 
 #define VID_MEM_IDX         184
-#define TERM0_BUFF          VID_MEM_IDX + 1
-#define TERM1_BUFF          VID_MEM_IDX + 2
-#define TERM2_BUFF          VID_MEM_IDX + 3
 
 #define K_VIDEO_IDX         0
 #define KERNEL_IDX          1
+#define DIRECT_IDX          2
 #define PROGRAM_IDX         32
 #define U_VIDEO_IDX         35
+#define FMAP_IDX            36
+#define ANON_IDX            37
 #define VID_OFFSET          12
 
 #define PR                  0x01
 #define RW                  0x02
 #define USR                 0x04
 #define PAGE_4MB            0x80
+#define GLOBAL              0x100
+// available bit: read-only page that is copied on the first write
+#define COW                 0x200
+// available bit: not present page of an anonymous mapping, zero filled on
+// first touch
+#define ANON_RESERVED       0x400
+// available bit: page of a shared memory segment, stays writable and shared
+// across fork instead of becoming copy-on-write
+#define SHARED              0x800
+
+// system call ring page, next to the vidmap page in the same page table
+#define RING_PAGE           1
+#define RING_ADDR           (_140_MB + RING_PAGE * _4_KB)
+
+// program images whose pages are kept for the next execute of the same file
+#define IMG_CACHE_SLOTS     8
+#define IMG_CACHE_PAGES     ((_4_MB - (PROG_IMG_ADDR - _128_MB)) / _4_KB)
+#define NO_INODE            -1
+
+#define CR4_PGE             0x80
 
 uint32_t page_table[_1_KB] __attribute__((aligned(_4_KB)));
 uint32_t page_dir[_1_KB] __attribute__((aligned(_4_KB)));
 
-/* maps running program to virutal address 128MB */
+// pages of program images loaded by page_in, and pages those images span
+extern uint32_t exec_pages_faulted;
+extern uint32_t exec_pages_total;
+// pages copied because a forked process wrote to a shared page
+extern uint32_t cow_pages_copied;
+// image pages mapped from the image cache instead of read from the file
+extern uint32_t exec_pages_shared;
+
+/* switches to the page directory of a process */
 extern void map_program(uint32_t pid);
+/* marks every page of a process' program window not present */
+extern int32_t reset_program(uint32_t pid);
+/* frees the frames and page tables of a halted process */
+extern void release_program(uint32_t pid);
+/* loads the page holding addr into the running program's window */
+extern int32_t page_in(uint32_t addr);
+/* reserves pages in the anonymous mapping window */
+extern uint32_t map_anon(uint32_t pid, uint32_t pages);
+/* frees the pages of [start, end) in a process' windows */
+extern void unmap_user(uint32_t pid, uint32_t start, uint32_t end);
+// maps the frames of a shared memory segment into the anonymous memory window
+extern uint32_t map_shared(uint32_t pid, uint32_t addr, const uint32_t* frames, uint32_t pages);
+/* frame holding a page of a program image, read from the file if not cached */
+extern uint32_t img_cache_page(uint32_t inode, uint32_t offset);
+/* drops the least recently used image from the cache */
+extern int32_t img_cache_shrink(void);
+/* shares a process' program pages copy-on-write with a forked child */
+extern int32_t fork_program(uint32_t parent_pid, uint32_t child_pid);
+/* gives a process its own copy of a shared page it wrote to */
+extern int32_t cow_fault(uint32_t addr);
 /* initializes pages */
 extern void paging_init(void);
 /* helps user program write to video memory */
-extern void map_video(void);
+extern int32_t map_video(void);
+/* maps a zeroed system call ring page into the running process */
+extern int32_t map_ring(uint32_t pid);
+/* maps a file's data blocks read-only at virtual address 144MB */
+extern int32_t map_file(uint32_t pid, uint32_t inode);
+/* removes a process' file mapping */
+extern void unmap_file(uint32_t pid);
 /* unmaps page after program is finished writing */
 extern void unmap_video(void);
-/* maps virtual memory video to visible terminal */
+/* shows a terminal by moving the VGA display start to its page */
 extern void switch_display(int32_t tid);
 /* flushes TLB when memory map altered */
 void flush(void);
+/* switches to another page directory */
+void load_page_dir(uint32_t* dir);
+/* turns CR4.PGE (global pages) on or off */
+void set_global_pages(int32_t enable);
+
+/* invlpg
+ * Drops the TLB entry of one page, global or not, instead of flushing
+ * the whole TLB with a CR3 reload
+ * parameter - addr : any virtual address in the page
+ */
+static inline void invlpg(uint32_t addr) {
+    asm volatile("invlpg (%0)" : : "r"(addr) : "memory");
+}
 
 #endif
@@ -0,0 +1,153 @@
+#include "pipe.h"
+#include "kmalloc.h"
+#include "scheduler.h"
+
+file_ops_t fops_pipe_read = {bad_call, pipe_close, pipe_read, bad_call};
+file_ops_t fops_pipe_write = {bad_call, pipe_close, bad_call, pipe_write};
+
+static kmem_cache_t* pipe_cache;
+
+/* pipe_of
+ * description - pipe behind a descriptor of the running process
+ * parameters - fd : descriptor of a pipe end
+ * returns - the pipe
+ */
+static pipe_t* pipe_of(int32_t fd) {
+    return (pipe_t*)get_pcb(cur_pid)->fd_table[fd].inode;
+}
+
+/* pipe_init - CP5
+ * description - makes the slab cache pipes come from
+ * parameters - none
+ * returns - none
+ */
+void pipe_init(void) {
+    pipe_cache = kmem_cache_create((int8_t*)"pipe", sizeof(pipe_t));
+}
+
+/* pipe_create - CP5
+ * description - allocates an empty pipe with one read and one write end
+ * parameters - rd, wr : free descriptors for the two ends
+ * returns - 0 on success, -1 if memory is exhausted
+ */
+int32_t pipe_create(file_desc_t* rd, file_desc_t* wr) {
+    pipe_t* p;
+    if(pipe_cache == NULL || (p = kmem_cache_alloc(pipe_cache)) == NULL)
+        return -1;
+    if((p->buf = kmalloc(PIPE_SIZE)) == NULL) {
+        kmem_cache_free(pipe_cache, p);
+        return -1;
+    }
+    p->head = 0;
+    p->tail = 0;
+    p->readers = 1;
+    p->writers = 1;
+    p->read_wq.head = p->read_wq.tail = NO_PID;
+    p->write_wq.head = p->write_wq.tail = NO_PID;
+
+    rd->fops_ptr = &fops_pipe_read;
+    wr->fops_ptr = &fops_pipe_write;
+    rd->inode = wr->inode = (uint32_t)p;
+    rd->file_pos = wr->file_pos = 0;
+    rd->flags = wr->flags = 1;
+    return 0;
+}
+
+/* pipe_ref - CP5
+ * description - a descriptor was copied (fork, dup2, inherited by execute),
+ *               the end it refers to has one more user
+ * parameters - fd : the copy
+ * returns - none
+ */
+void pipe_ref(file_desc_t* fd) {
+    if(!fd->flags)
+        return;
+    if(fd->fops_ptr == &fops_pipe_read)
+        ((pipe_t*)fd->inode)->readers++;
+    else if(fd->fops_ptr == &fops_pipe_write)
+        ((pipe_t*)fd->inode)->writers++;
+}
+
+/* pipe_read - CP5
+ * description - blocks until the pipe has data or every write end is
+ *               closed, then takes what is there
+ * parameters - fd : read end
+ *              buf : destination
+ *              nbytes : most bytes to read
+ * returns - bytes read, 0 at end of file
+ */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes) {
+    pipe_t* p = pipe_of(fd);
+    uint32_t n, i;
+
+    cli();
+    while(p->head == p->tail && p->writers > 0)
+        sleep_on(&p->read_wq);
+    n = p->tail - p->head;
+    if(n > (uint32_t)nbytes)
+        n = nbytes;
+    for(i = 0; i < n; ++i)
+        ((uint8_t*)buf)[i] = p->buf[(p->head + i) % PIPE_SIZE];
+    p->head += n;
+    if(n > 0)
+        wake_up(&p->write_wq);
+    return n;
+}
+
+/* pipe_write - CP5
+ * description - copies all of buf into the pipe, blocking whenever it is
+ *               full, so a producer runs at the pace of its consumer
+ * parameters - fd : write end
+ *              buf : source
+ *              nbytes : bytes to write
+ * returns - nbytes, fewer if every read end closed meanwhile, -1 if none
+ *           was open to begin with
+ */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes) {
+    pipe_t* p = pipe_of(fd);
+    uint32_t n, i, done;
+
+    cli();
+    for(done = 0; done < (uint32_t)nbytes; done += n) {
+        while(p->tail - p->head == PIPE_SIZE && p->readers > 0)
+            sleep_on(&p->write_wq);
+        if(p->readers == 0)
+            return done > 0 ? (int32_t)done : -1;
+        n = PIPE_SIZE - (p->tail - p->head);
+        if(n > nbytes - done)
+            n = nbytes - done;
+        for(i = 0; i < n; ++i)
+            p->buf[(p->tail + i) % PIPE_SIZE] = ((const uint8_t*)buf)[done + i];
+        p->tail += n;
+        wake_up(&p->read_wq);
+    }
+    return done;
+}
+
+/* pipe_close - CP5
+ * description - drops an end. Sleepers on the other side are woken so
+ *               they see end of file or a broken pipe, and the pipe is
+ *               freed with its last end.
+ * parameters - fd : descriptor being closed, its fops and inode still set
+ * returns - 0
+ */
+int32_t pipe_close(int32_t fd) {
+    file_desc_t* f = &get_pcb(cur_pid)->fd_table[fd];
+    pipe_t* p = (pipe_t*)f->inode;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if(f->fops_ptr == &fops_pipe_read) {
+        p->readers--;
+        wake_up(&p->write_wq);
+    } else {
+        p->writers--;
+        wake_up(&p->read_wq);
+    }
+    if(p->readers == 0 && p->writers == 0) {
+        kfree(p->buf);
+        kmem_cache_free(pipe_cache, p);
+    }
+    restore_flags(flags);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include "types.h"
+#include "wait_queue.h"
+#include "system_calls.h"
+
+// bytes a pipe holds before writers block
+#define PIPE_SIZE           1024
+
+// byte channel between a read end and a write end. head and tail count the
+// bytes read and written so far, the data is at index % PIPE_SIZE.
+typedef struct pipe {
+    uint8_t* buf;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t readers;       // open read ends, across every process
+    uint32_t writers;       // open write ends
+    wait_queue_t read_wq;   // readers waiting for data
+    wait_queue_t write_wq;  // writers waiting for room
+} pipe_t;
+
+// file operations of the two ends
+extern file_ops_t fops_pipe_read;
+extern file_ops_t fops_pipe_write;
+
+// sets up the pipe cache
+void pipe_init(void);
+// makes a pipe and fills in the descriptors of its two ends
+int32_t pipe_create(file_desc_t* rd, file_desc_t* wr);
+// counts one more descriptor for a pipe end that was copied
+void pipe_ref(file_desc_t* fd);
+// file operations, the pipe is in the descriptor's inode field
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t pipe_close(int32_t fd);
+
+#endif /* _PIPE_H */
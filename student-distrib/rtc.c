@@ -3,12 +3,50 @@
 #include "lib.h"
 #include "i8259.h"
 #include "rtc.h"
+#include "scheduler.h"
+#include "system_calls.h"
+
+// hardware RTC interrupts since boot, every fd counts its virtual ticks on it
+volatile uint32_t rtc_ticks;
+// earliest tick a reader in rtc_read waits for, valid while rtc_waiting is
+// set since every value is also a tick the counter can reach
+volatile uint32_t rtc_wake_at;
+volatile uint8_t rtc_waiting;
+// processes blocked in rtc_read
+wait_queue_t rtc_wq = WAIT_QUEUE_INIT;
+// divider for the kernel's own RTC use before any process runs (tests)
+static uint32_t rtc_kernel_div = RTC_HW_FREQ / RTC_OPEN_FREQ;
+
+/* rtc_get_div
+    DESCRIPTION: looks up the tick divider of an RTC fd of the running process
+    INPUTS: fd - open RTC file descriptor
+    OUTPUTS: none
+    RETURN VALUE: hardware ticks per virtual tick of fd
+    SIDE EFFECTS: none
+*/
+static uint32_t rtc_get_div(int32_t fd) {
+    if(cur_pid < 0)
+        return rtc_kernel_div;
+    return get_pcb(cur_pid)->fd_table[fd].inode;
+}
 
-// flag to set if interrupt has been received - used for reading only after interrupt
-volatile int rtc_int_received;
+/* rtc_set_div
+    DESCRIPTION: sets the tick divider of an RTC fd of the running process
+    INPUTS: fd - open RTC file descriptor
+            div - hardware ticks per virtual tick
+    OUTPUTS: none
+    RETURN VALUE: none
+    SIDE EFFECTS: none
+*/
+static void rtc_set_div(int32_t fd, uint32_t div) {
+    if(cur_pid < 0)
+        rtc_kernel_div = div;
+    else
+        get_pcb(cur_pid)->fd_table[fd].inode = div;
+}
 
 /* initialize_rtc
-    DESCRIPTION: initializes RTC by setting the default frequency and enabling on the PIC
+    DESCRIPTION: initializes RTC at the fixed hardware rate and enables it on the PIC
     INPUTS: none
     OUTPUTS: enables IRQ8 on the PIC, writes to the RTC registers
     RETURN VALUE: none
@@ -26,8 +64,12 @@ void initialize_rtc() {
     outb(NMI_REG_B, SELECT_REG);
     // OR to turn on 6th bit of register B
     outb(prev | BIT_6_MASK, DATA_REG);
-    // set interrupt flag to 0
-    rtc_int_received = 0;
+    // the hardware always runs at 1024Hz, fds divide it down
+    outb(NMI_REG_A, SELECT_REG);
+    prev = inb(DATA_REG);
+    outb(NMI_REG_A, SELECT_REG);
+    outb((prev & HIGH_BIT_MASK) | RTC_HW_RATE, DATA_REG);
+    rtc_ticks = 0;
 
     // sti();
 
@@ -39,55 +81,70 @@ void initialize_rtc() {
 }
 
 /* rtc_open
-    DESCRIPTION: initializes RTC by enabling on PIC, then sets frequency to 2Hz
+    DESCRIPTION: opens a virtual RTC running at 2Hz. The open syscall sets
+                 the fd's divider, this only resets the kernel's own one.
     INPUTS: filename (unused)
-    OUTPUTS: sets frequency in Register A to 2Hz, enables IRQ8 on PIC
+    OUTPUTS: none
     RETURN VALUE: 0 on success
     SIDE EFFECTS: none
 */
 int32_t rtc_open(const uint8_t* filename) {
-    initialize_rtc();
-
-    // disable interrupts to set registers
-    cli();
-
-    outb(NMI_REG_A, SELECT_REG);
-    char prev = inb(DATA_REG);
-    outb(NMI_REG_A, SELECT_REG);
-    // set frequency to 2Hz
-    outb((prev & HIGH_BIT_MASK) | TWO_HZ_FREQ, DATA_REG);
-
-    // sti();
-
+    if(cur_pid < 0)
+        rtc_kernel_div = RTC_HW_FREQ / RTC_OPEN_FREQ;
     return 0;
 }
 
 /* rtc_read
-    DESCRIPTION: blocks until interrupt has been received through RTC interrupt flag
-    INPUTS: fd, buf, nbytes (all unused)
+    DESCRIPTION: blocks until the next virtual tick of fd. Virtual ticks fall
+                 on multiples of the fd's divider, so the period stays exact
+                 however late the reader comes back.
+    INPUTS: fd - RTC file descriptor
+            buf, nbytes (unused)
     OUTPUTS: none
     RETURN VALUE: 0 on success
-    SIDE EFFECTS: none
+    SIDE EFFECTS: sleeps on rtc_wq, other processes run meanwhile
 */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes) {
-    // reset interrupt flag after read
-    rtc_int_received = 0;
+    uint32_t div = rtc_get_div(fd);
+    uint32_t target;
 
-    sti();
-    while(!rtc_int_received) {
-        // block until the next interrupt
-    }
     cli();
+    target = (rtc_ticks / div + 1) * div;
+    // signed difference so the comparison survives the counter wrapping
+    while((int32_t)(rtc_ticks - target) < 0) {
+        if(!rtc_waiting || (int32_t)(target - rtc_wake_at) < 0)
+            rtc_wake_at = target;
+        rtc_waiting = 1;
+        // block until the virtual tick
+        sleep_on(&rtc_wq);
+    }
 
     return 0;
 }
 
+/* rtc_tick
+    DESCRIPTION: counts a hardware RTC interrupt and wakes the readers once
+                 the earliest virtual tick any of them waits for is reached
+    INPUTS: none
+    OUTPUTS: none
+    RETURN VALUE: none
+    SIDE EFFECTS: called from rtc_handler with interrupts off
+*/
+void rtc_tick(void) {
+    rtc_ticks++;
+    if(rtc_waiting && (int32_t)(rtc_ticks - rtc_wake_at) >= 0) {
+        // readers still early go back to sleep and set a new wake time
+        rtc_waiting = 0;
+        wake_up(&rtc_wq);
+    }
+}
+
 /* rtc_write
-    DESCRIPTION: sets the RTC to a certain frequency, with error checking
-    INPUTS: fd (unused)
+    DESCRIPTION: sets the virtual frequency of an RTC fd, with error checking
+    INPUTS: fd - RTC file descriptor
             buf - buffer that contains desired frequency
             nbytes - needs to accept 4 byte rate
-    OUTPUTS: writes to the RTC registers
+    OUTPUTS: none, the hardware rate never changes
     RETURN VALUE: number of bytes written, -1 on fail
     SIDE EFFECTS: none
 */
@@ -104,22 +161,8 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes) {
     }
     // sys call only accepts 4 byte int - Appendix B
     if(nbytes == INT_BYTES && freq <= HIGH_LIMIT_FREQ) {
-        // count power of 2 by finding where the 1 bit is
-        int pow = 0;
-        while(freq >>= 1) {
-            ++pow;
-        }
-        // write new frequency into Register A - block interrupts while writing
-        cli();
-        // disable NMI interrupt and select Register A
-        outb(NMI_REG_A, SELECT_REG);
-        char prev = inb(DATA_REG);
-        // set index again
-        outb(NMI_REG_A, SELECT_REG);
-        // set rate based on offset from 2Hz rate
-        outb((prev & HIGH_BIT_MASK) | (TWO_HZ_FREQ - pow + FREQ_OFFSET), DATA_REG);
-
-        // sti();
+        // the hardware rate is a power of two too, so this divides exactly
+        rtc_set_div(fd, RTC_HW_FREQ / freq);
     } else {
         return -1;
     }
@@ -2,6 +2,7 @@
 #define _RTC_H
 
 #include "types.h"
+#include "wait_queue.h"
 
 #define IRQ_RTC 8
 #define SELECT_REG  0x70
@@ -17,9 +18,16 @@
 #define NUM_READ_INTS   10
 #define INTS_ROW_LIMIT  30
 #define FREQ_OFFSET     2
+// fixed hardware rate, Register A rate 6 is 32768 >> 5 = 1024Hz
+#define RTC_HW_RATE     0x06
+#define RTC_HW_FREQ     1024
+// virtual frequency of a newly opened RTC fd
+#define RTC_OPEN_FREQ   2
     
 
-volatile int rtc_int_received;
+extern volatile uint32_t rtc_ticks;
+// processes blocked in rtc_read, woken when a virtual tick is due
+extern wait_queue_t rtc_wq;
 
 void initialize_rtc();
 
@@ -27,6 +35,7 @@ int32_t rtc_open(const uint8_t* filename);
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
 int32_t rtc_close(int32_t fd);
+void rtc_tick(void);
 
 
 
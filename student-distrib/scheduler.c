@@ -1,101 +1,278 @@
 #include "scheduler.h"
-// SCHEDULER.C IS NOT IN USE!!!
-volatile int schedule_init;
+
+int32_t cur_pid = -1;
+uint32_t sched_slice_ms = DEFAULT_SLICE_MS;
+
+// circular queue of runnable pids, the running process is not in it
+static int32_t run_queue[PROCESS_COUNT];
+static uint32_t rq_head;
+static uint32_t rq_count;
+
+// set while the CPU halts in sleep_on with nothing runnable
+static volatile int32_t sched_idle;
+// nonzero while deferred interrupt work runs with interrupts on
+static uint32_t preempt_count;
+// time slices elapsed, and how many of them found the CPU halted
+uint32_t sched_ticks;
+uint32_t sched_idle_ticks;
 
 /* pit_init - CP5
- * description - initialize the pit
+ * description - initialize the pit to interrupt once per time slice
  * parameters - none
  * returns - none
  */
 void pit_init(void) {
-    // initialize PIT to interrupts at 10ms frequency (10ms = 100Hz)
-    uint32_t freq = TEN_MS;
-    uint32_t divisor = MAX_FREQ / freq;
+    sched_set_slice(sched_slice_ms);
+    enable_irq(IRQ_PIT);
+}
+
+/* sched_set_slice - CP5
+ * description - sets the time slice length and reprograms the PIT for it
+ * parameters - ms : time slice in milliseconds
+ * returns - 0 on success, -1 if ms is out of range
+ */
+int32_t sched_set_slice(uint32_t ms) {
+    uint32_t flags;
+    uint32_t divisor;
+    if(ms < MIN_SLICE_MS || ms > MAX_SLICE_MS)
+        return -1;
+    divisor = MAX_FREQ * ms / MS_PER_SEC;
+
     // disable interrupts to set registers
-    cli();
+    cli_and_save(flags);
+    sched_slice_ms = ms;
     // set command register - select channel 0, lobyte/hibyte, and rate generator - 0011 0110
     outb(PIT_CMD, CMD_REG);
     // set high and low byte using outb (1 byte at a time)
     outb(divisor & LOW_8_BIT_MASK, CHANNEL_0);
     outb((divisor & HIGH_8_BIT_MASK) >> TWO_BYTE, CHANNEL_0);
-    sti();
-    enable_irq(IRQ_PIT);
+    restore_flags(flags);
+    return 0;
+}
+
+/* rq_push - CP5
+ * description - adds a process to the back of the run queue
+ * parameters - pid : runnable process
+ * returns - none
+ */
+void rq_push(int32_t pid) {
+    uint32_t flags;
+
+    cli_and_save(flags);
+    run_queue[(rq_head + rq_count) % PROCESS_COUNT] = pid;
+    rq_count++;
+    restore_flags(flags);
+}
+
+/* rq_pop
+ * description - takes the process at the front of the run queue
+ * parameters - none
+ * returns - pid, or NO_PID if nothing is runnable
+ */
+static int32_t rq_pop(void) {
+    int32_t pid;
+    if(rq_count == 0)
+        return NO_PID;
+    pid = run_queue[rq_head];
+    rq_head = (rq_head + 1) % PROCESS_COUNT;
+    rq_count--;
+    return pid;
+}
+
+/* sched_switch
+ * description - switches the CPU from the running process to next: kernel
+ *               stack in the TSS, program paging, then the kernel stack
+ *               itself. The interrupt/system call linkage already saved the
+ *               user registers on the old kernel stack, kstack_switch saves
+ *               the rest, so the old process resumes exactly where it left.
+ * parameters - next : pid to run
+ * returns - once the old process is scheduled again
+ */
+static void sched_switch(int32_t next) {
+    pcb_t* prev_pcb = get_pcb(cur_pid);
+    pcb_t* next_pcb = get_pcb(next);
+
+    cur_pid = next;
+    t_cur = next_pcb->tid;
+
+    tss.ss0 = KERNEL_DS;
+    tss.esp0 = KSTACK_TOP(next);
+    // remap + flush TLB
+    map_program(next);
+
+    kstack_switch((void*)&prev_pcb->ksp, next_pcb->ksp);
 }
 
 /* schedule - CP5
- * description - schedular that runs the scheduling
+ * description - round robin: puts the running process at the back of the
+ *               run queue and switches to the one at the front. Called from
+ *               the PIT handler with interrupts off.
  * parameters - none
  * returns - none
  */
 void schedule(void) {
-    // round robin scheduling
-    cli();
-    int i;
-    int32_t t_next = (t_cur + 1) % TERMINAL_COUNT;
-    
-    // first three bootup - start the three terminals
-    if(t[t_cur].shell_flag == -1 /* maybe use -1 for nothing */) {
-
-        // process_status[t_cur] = 1; /* in the future set to terminal id  */
-        t[t_cur].running_process = t_cur;
-        // t[t_cur].shell_flag = 0;
-        // parent pid of base is parent
-        // parent_pid_arr[i] = i;
-        // put current esp and ebp into pcb
-        pcb_t* pcb = get_pcb(t_cur);
-
-        asm volatile(
-            "movl %%esp, %0     \n"
-            "movl %%ebp, %1     \n"
-            :"=r"(pcb->cur_esp), "=r"(pcb->cur_ebp) // output
-            : // input
-        );
-        ++i;
-        
-        execute((uint8_t*)"shell");
-
-        // we will never get here
+    int32_t next;
+    sched_ticks++;
+    // while idle the running process is asleep, it must not be requeued
+    if(sched_idle) {
+        sched_idle_ticks++;
+        return;
+    }
+    // the slice runs over until the deferred work is done
+    if(cur_pid < 0 || rq_count == 0 || preempt_count > 0)
+        return;
+    next = rq_pop();
+    rq_push(cur_pid);
+    sched_switch(next);
+}
+
+/* preempt_disable - CP5
+ * description - keeps the PIT from switching processes, for interrupt work
+ *               that runs with interrupts on but must finish on the stack
+ *               it started on. Nests. Must be called with interrupts off.
+ * parameters - none
+ * returns - none
+ */
+void preempt_disable(void) {
+    preempt_count++;
+}
+
+/* preempt_enable - CP5
+ * description - undoes preempt_disable, the next PIT tick may switch again.
+ *               Must be called with interrupts off.
+ * parameters - none
+ * returns - none
+ */
+void preempt_enable(void) {
+    preempt_count--;
+}
+
+/* sleep_on - CP5
+ * description - blocks the running process on wq and runs someone else. If
+ *               nothing is runnable the CPU halts until an interrupt wakes a
+ *               process. Callers re-check their condition when this returns.
+ *               Must be called with interrupts off.
+ * parameters - wq : queue to sleep on
+ * returns - once woken by wake_up and scheduled again
+ */
+void sleep_on(wait_queue_t* wq) {
+    int32_t next;
+    pcb_t* pcb;
+
+    // no process yet (kernel tests at boot), just wait for an interrupt
+    if(cur_pid < 0) {
+        asm volatile("sti; hlt; cli" ::: "memory");
         return;
     }
+    pcb = get_pcb(cur_pid);
+    pcb->wait_next = NO_PID;
+    if(wq->tail == NO_PID)
+        wq->head = cur_pid;
+    else
+        get_pcb(wq->tail)->wait_next = cur_pid;
+    wq->tail = cur_pid;
 
-    // all other schedule calls
-    if(t[t_next].shell_flag == -1 || i == TERMINAL_COUNT) {
-        t_cur = t_next;
-        send_eoi(IRQ_PIT);
-        if (i == TERMINAL_COUNT) 
-            i = 0;
+    // halt until an interrupt handler makes a process runnable
+    while((next = rq_pop()) == NO_PID) {
+        sched_idle = 1;
+        asm volatile("sti; hlt; cli" ::: "memory");
+        sched_idle = 0;
+    }
+    // woken before anyone else got the CPU, keep running
+    if(next == cur_pid)
         return;
+    sched_switch(next);
+}
+
+/* sched_exit - CP5
+ * description - ends the running process when there is no parent frame to
+ *               return to (a forked child). Its address space and pid are
+ *               freed right away, its kernel stack is kept by the pid and
+ *               nobody can take the pid before the switch since interrupts
+ *               stay off. Must be called with interrupts off.
+ * parameters - none
+ * returns - never
+ */
+void sched_exit(void) {
+    int32_t next;
+
+    // the dying directory can't stay in CR3 once it is freed
+    load_page_dir(page_dir);
+    release_program(cur_pid);
+    pid_release(cur_pid);
+
+    while((next = rq_pop()) == NO_PID) {
+        sched_idle = 1;
+        asm volatile("sti; hlt; cli" ::: "memory");
+        sched_idle = 0;
+    }
+    sched_switch(next);
+}
+
+/* wake_up - CP5
+ * description - empties wq onto the run queue, in the order processes slept
+ * parameters - wq : queue to wake
+ * returns - none
+ */
+void wake_up(wait_queue_t* wq) {
+    int32_t pid;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    while((pid = wq->head) != NO_PID) {
+        wq->head = get_pcb(pid)->wait_next;
+        rq_push(pid);
     }
-    // get next process pcb
-    pcb_t* old_pcb = get_pcb(t[t_cur].running_process);
-    pcb_t* cur_pcb = get_pcb(t[t_next].running_process);
+    wq->tail = NO_PID;
+    restore_flags(flags);
+}
 
-    // switch ESP/EBP to next process' kernel stack
-    tss.ss0 = KERNEL_DS;
-    tss.esp0 = _8_MB - _8_KB * cur_pcb->pid - FOUR_BYTE;
-
-    // remap + flush TLB 
-    map_program(cur_pcb->pid);
-    
-    
-    // restore next process' TSS
-    asm volatile(
-        "movl %%esp, %0\n\
-        movl %%ebp, %1"
-        :"=r"(old_pcb->cur_esp), "=r"(old_pcb->cur_ebp) // output
-        : // input
-    );
-
-    // process switch
-    asm volatile(
-        "movl %0, %%esp\n\
-        movl %1, %%ebp"
-        : //ouput
-        :"r"(cur_pcb->cur_esp), "r"(cur_pcb->cur_ebp) //input
-    );
-    // update the terminal id and enable interrupt again
-    t_cur = t_next;
+/* sched_shell_entry
+ * description - first code a spawned base shell runs, on its own kernel stack
+ * parameters - none
+ * returns - never
+ */
+static void sched_shell_entry(void) {
+    execute((uint8_t*)"shell");
+    // only gets here if the shell could not be started
+    printf("Could not start shell in terminal %d\n", t_cur);
     sti();
-    return;
+    while(1) asm volatile("hlt");
+}
+
+/* sched_spawn_shell - CP5
+ * description - the base shell of terminal tid owns pid tid. Builds a kernel
+ *               stack for it that kstack_switch "returns" into
+ *               sched_shell_entry, and queues it to run. Runs with
+ *               interrupts off, the keyboard bottom half calls it with IF set.
+ * parameters - tid : terminal without a shell
+ * returns - none
+ */
+void sched_spawn_shell(int32_t tid) {
+    uint32_t* stack;
+    pcb_t* pcb;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if(t[tid].running_process != -1 || (pcb = pcb_alloc(tid)) == NULL) {
+        restore_flags(flags);
+        return;
+    }
+    stack = (uint32_t*)KSTACK_TOP(tid);
+
+    // frame popped by kstack_switch: edi, esi, ebx, ebp, eflags, return address
+    stack[-1] = (uint32_t)sched_shell_entry;
+    stack[-2] = EFLAGS_BASE;
+    stack[-3] = 0;
+    stack[-4] = 0;
+    stack[-5] = 0;
+    stack[-6] = 0;
+    pcb->ksp = (uint32_t)&stack[-6];
+    pcb->pid = tid;
+    pcb->tid = tid;
+    pcb->fmap_fd = NO_FMAP;
 
+    t[tid].running_process = tid;
+    rq_push(tid);
+    restore_flags(flags);
 }
@@ -1,29 +1,55 @@
 #ifndef _SCHEDULER_H
 #define _SCHEDULER_H
 
-// SCHEDULAR IS NOT IN USE!!!
-
 #include "system_calls.h"
 #include "filesys.h"
 #include "i8259.h"
 #include "paging.h"
 #include "terminal.h"
+#include "wait_queue.h"
 
 #define IRQ_PIT          0
 
 #define PIT_CMD         0x36
 #define CHANNEL_0       0x40
 #define CMD_REG         0x43
-#define TEN_MS          100
 #define MAX_FREQ        1193182
 #define TWO_BYTE        8
 
 #define HIGH_8_BIT_MASK 0xFF00
 #define LOW_8_BIT_MASK  0xFF
 
+// time slice in ms, bounded by the 16 bit PIT divisor (~54ms)
+#define DEFAULT_SLICE_MS    10
+#define MIN_SLICE_MS        1
+#define MAX_SLICE_MS        50
+#define MS_PER_SEC          1000
+
+// EFLAGS a new kernel context starts with (reserved bit 1 set, IF clear)
+#define EFLAGS_BASE         0x02
+
+// pid of the process on the CPU, -1 before the first shell
+extern int32_t cur_pid;
+// length of a time slice in ms
+extern uint32_t sched_slice_ms;
+// time slices elapsed, and how many the CPU spent halted with nothing to run
+extern uint32_t sched_ticks;
+extern uint32_t sched_idle_ticks;
+
 // initialize the pit
 void pit_init(void);
-// schedular that runs the scheduling
+// reprograms the pit for a new time slice length
+int32_t sched_set_slice(uint32_t ms);
+// round robin to the next runnable process
 void schedule(void);
+// keep the PIT from switching away while deferred interrupt work runs
+void preempt_disable(void);
+void preempt_enable(void);
+// adds a process to the back of the run queue
+void rq_push(int32_t pid);
+// gives up the CPU for good, the exiting process is never run again
+void sched_exit(void);
+// queues the base shell of a terminal to be started by the scheduler
+void sched_spawn_shell(int32_t tid);
 
 #endif
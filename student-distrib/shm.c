@@ -0,0 +1,86 @@
+#include "shm.h"
+#include "frame.h"
+#include "kmalloc.h"
+#include "lib.h"
+
+static shm_seg_t shm_segs[SHM_SEGMENTS];
+
+/* shm_release
+ * description - drops the segment's own reference on its frames, pages
+ *               still mapped somewhere stay with that process
+ * parameters - seg : segment in use
+ * returns - none
+ */
+static void shm_release(shm_seg_t* seg) {
+    uint32_t i;
+    for(i = 0; i < seg->pages; ++i)
+        frame_free(seg->frames[i]);
+    kfree(seg->frames);
+    seg->frames = NULL;
+    seg->pages = 0;
+}
+
+/* shm_reclaim
+ * description - frees segments no process maps anymore. A segment holds
+ *               one reference on each frame and every mapping another, so
+ *               a segment none of whose frames is shared is unused.
+ * parameters - none
+ * returns - none
+ */
+static void shm_reclaim(void) {
+    uint32_t i, j;
+    for(i = 0; i < SHM_SEGMENTS; ++i) {
+        if(shm_segs[i].pages == 0)
+            continue;
+        for(j = 0; j < shm_segs[i].pages && !frame_shared(shm_segs[i].frames[j]); ++j);
+        if(j == shm_segs[i].pages)
+            shm_release(&shm_segs[i]);
+    }
+}
+
+/* shm_get - CP5
+ * description - looks a segment up by name. A name nobody maps anymore is
+ *               forgotten, the next shm_get of it makes a new zero filled
+ *               segment of the size asked for.
+ * parameters - name : segment name, shorter than SHM_NAME_LEN
+ *              pages : pages the caller wants to map
+ * returns - the segment, NULL if an existing one is smaller than pages,
+ *           the name is too long, every slot is taken or memory is
+ *           exhausted
+ */
+shm_seg_t* shm_get(const int8_t* name, uint32_t pages) {
+    shm_seg_t* seg = NULL;
+    uint32_t i, flags;
+
+    if(pages == 0 || strlen(name) == 0 || strlen(name) >= SHM_NAME_LEN)
+        return NULL;
+    cli_and_save(flags);
+    shm_reclaim();
+    for(i = 0; i < SHM_SEGMENTS; ++i) {
+        if(shm_segs[i].pages == 0) {
+            if(seg == NULL)
+                seg = &shm_segs[i];
+        } else if(strncmp(name, shm_segs[i].name, SHM_NAME_LEN) == 0) {
+            restore_flags(flags);
+            return pages <= shm_segs[i].pages ? &shm_segs[i] : NULL;
+        }
+    }
+    if(seg == NULL || (seg->frames = kmalloc(pages * sizeof(uint32_t))) == NULL) {
+        restore_flags(flags);
+        return NULL;
+    }
+    for(i = 0; i < pages; ++i) {
+        if((seg->frames[i] = frame_alloc()) == 0) {
+            seg->pages = i;
+            shm_release(seg);
+            restore_flags(flags);
+            return NULL;
+        }
+        // frames are mapped 1:1 in the kernel
+        memset((void*)seg->frames[i], 0, _4_KB);
+    }
+    seg->pages = pages;
+    strncpy(seg->name, name, SHM_NAME_LEN);
+    restore_flags(flags);
+    return seg;
+}
@@ -0,0 +1,22 @@
+#ifndef _SHM_H
+#define _SHM_H
+
+#include "types.h"
+
+// named segments that can exist at once
+#define SHM_SEGMENTS        16
+// longest name, terminator included
+#define SHM_NAME_LEN        32
+
+// shared memory segment: zero filled frames found by name, every process
+// that maps it sees the same memory (see map_shared)
+typedef struct shm_seg {
+    int8_t name[SHM_NAME_LEN];
+    uint32_t pages;         // 0 for a free slot
+    uint32_t* frames;       // physical address of every page
+} shm_seg_t;
+
+// finds the segment with a name, creating it if there is none
+shm_seg_t* shm_get(const int8_t* name, uint32_t pages);
+
+#endif /* _SHM_H */
@@ -1,4 +1,16 @@
 #include "system_calls.h"
+#include "frame.h"
+#include "pipe.h"
+#include "shm.h"
+
+// pcb + kernel stack (one 8KB block from the frame allocator) of every pid
+static pcb_t* pcb_table[PROCESS_COUNT];
+uint32_t process_limit;
+// stack of free pids above the base shells', lowest on top
+static int32_t pid_free_list[PROCESS_COUNT];
+static uint32_t pid_free_count;
+
+static int32_t fd_close (int32_t fd);
 
 // static tables with function pointers for each file type
 file_ops_t fops_rtc = {rtc_open, rtc_close, rtc_read, rtc_write};
@@ -40,18 +52,111 @@ void pcb_init(pcb_t *pcb) {
     pcb->fd_table[1] = stdout;
 
     //pid from 0 - 5
-    pcb->pid = t[t_visible].running_process;
+    pcb->pid = t[t_cur].running_process;
+    pcb->tid = t_cur;
+    pcb->fmap_fd = NO_FMAP;
+    pcb->forked = 0;
 
     return;
 }
 
+/* process_init - CP5
+ * Marks every pid free and limits the number of processes to what the free
+ * physical memory can hold, keeping at least the base shells.
+ * parameters - none
+ * returns - none
+ * side effects - sets process_limit
+ */
+void process_init(void) {
+    int p;
+    for(p = 0; p < PROCESS_COUNT; p++)
+        process_status[p] = -1;
+    process_limit = frames_free / PROC_FRAMES;
+    if(process_limit > PROCESS_COUNT)
+        process_limit = PROCESS_COUNT;
+    if(process_limit < TERMINAL_COUNT)
+        process_limit = TERMINAL_COUNT;
+    pid_free_count = 0;
+    for(p = process_limit - 1; p >= TERMINAL_COUNT; p--)
+        pid_free_list[pid_free_count++] = p;
+}
+
+/* pid_alloc - CP5
+ * Takes a free pid for a new process in O(1).
+ * parameters - none
+ * returns - pid, NO_PID if every pid is taken
+ */
+int32_t pid_alloc(void) {
+    if(pid_free_count == 0)
+        return NO_PID;
+    return pid_free_list[--pid_free_count];
+}
+
+/* pid_release - CP5
+ * Puts the pid of a finished process back on the free list. The base shell
+ * pids are never on it.
+ * parameters - pid_in : pid to free
+ * returns - none
+ */
+void pid_release(int pid_in) {
+    if(pid_in >= TERMINAL_COUNT)
+        pid_free_list[pid_free_count++] = pid_in;
+}
+
 /* get_pcb - CP3
  * Fills in given struct with correct pcb info
  * parameters - pid_in : pid num of pcb struct to find
- * returns - none
+ * returns - pcb at the bottom of the pid's kernel stack block
  */
 pcb_t* get_pcb(int pid_in) {
-   return (pcb_t*)(_8_MB - _8_KB * (pid_in + 1));
+   return pcb_table[pid_in];
+}
+
+/* pcb_alloc - CP5
+ * The pcb and kernel stack of a pid come from the frame allocator the first
+ * time the pid is used and are kept for whoever takes the pid next.
+ * parameters - pid_in : pid that is about to run
+ * returns - the pcb, NULL if memory is exhausted
+ */
+pcb_t* pcb_alloc(int pid_in) {
+    pcb_t* pcb = pcb_table[pid_in];
+    if(pcb == NULL) {
+        pcb = (pcb_t*)frame_alloc_n(KSTACK_FRAMES);
+        if(pcb == NULL)
+            return NULL;
+        memset(pcb, 0, sizeof(pcb_t));
+        pcb_table[pid_in] = pcb;
+    }
+    return pcb;
+}
+
+/* image_end
+ * Finds where a program's bss ends from the PT_LOAD entries of its ELF
+ * program headers, the heap starts at the next page
+ * parameters - inode : program file
+ *              length : file length
+ * returns - page aligned start of the heap
+ */
+static uint32_t image_end(uint32_t inode, uint32_t length) {
+    uint32_t phoff, end, seg_end, i;
+    uint16_t phnum, phentsize;
+    uint32_t ph[PH_MEMSZ / FOUR_BYTE + 1];
+
+    end = PROG_IMG_ADDR + length;
+    if(read_data(inode, ELF_PHOFF, (uint8_t*)&phoff, FOUR_BYTE) != FOUR_BYTE ||
+       read_data(inode, ELF_PHNUM, (uint8_t*)&phnum, sizeof(phnum)) != sizeof(phnum) ||
+       read_data(inode, ELF_PHENTSIZE, (uint8_t*)&phentsize, sizeof(phentsize)) != sizeof(phentsize))
+        phnum = 0;
+    for(i = 0; i < phnum; ++i) {
+        if(read_data(inode, phoff + i * phentsize, (uint8_t*)ph, sizeof(ph)) != sizeof(ph))
+            break;
+        if(ph[PH_TYPE / FOUR_BYTE] != PT_LOAD)
+            continue;
+        seg_end = ph[PH_VADDR / FOUR_BYTE] + ph[PH_MEMSZ / FOUR_BYTE];
+        if(seg_end > end && seg_end <= _132_MB)
+            end = seg_end;
+    }
+    return (end + _4_KB - 1) & ~(_4_KB - 1);
 }
 
 /* execute - CP3
@@ -61,15 +166,7 @@ pcb_t* get_pcb(int pid_in) {
  * side effects - context switch from Kernel space to user space
  */
 int32_t execute (const uint8_t* command) {
-    // if all processes from 0 to 5 are filled, return -1
-    int p, found;
-    for(p = 0, found = 0; p < PROCESS_COUNT; ++p){
-        if(process_status[p] == -1){
-            found = 1;
-            break;
-        }
-    }
-    if(!found || t[t_visible].process_ct > MAX_PROC_PER_TERM) return -1;
+    int p;
 
     // clear interrupts
     cli();
@@ -133,37 +230,63 @@ int32_t execute (const uint8_t* command) {
     } else {
         return -1;
     }
+    // base shell of each terminal owns the pid matching the terminal id,
+    // everything else takes a pid off the free list
+    if(t[t_cur].shell_flag == -1) {
+        p = t_cur;
+    } else if((p = pid_alloc()) == NO_PID) {
+        return -1;
+    }
+    // kernel stack, pcb and program page table come from the frame allocator
+    if(pcb_alloc(p) == NULL || reset_program(p) == -1){
+        pid_release(p);
+        return -1;
+    }
     // getting the entry point from 24 - 27
     read_data(search.inode, ENTRY_POINT_START, buffer, FOUR_BYTE);
     entry_point = *((uint32_t*)buffer); //byte manipulation; shell val: 0x080482E8
 
-    // save currently running process as parent
-    int32_t parent_process = t[t_visible].running_process;
+    // save calling process as parent, it may be a forked child that is not
+    // the terminal's running process
+    int32_t parent_process = cur_pid;
     // update running process in terminal
-    t[t_visible].running_process = p;
-    process_status[t[t_visible].running_process] = 1;
-
-    //set up paging
-    map_program(t[t_visible].running_process);
-    // write file data into program image (virtual address)
-    inode_t* inode = &(inode_arr[search.inode]);
-    read_data(search.inode,0,(uint8_t *)PROG_IMG_ADDR, inode->length); // get length here
-
-    t[t_visible].process_ct++;
+    t[t_cur].running_process = p;
+    process_status[p] = t_cur;
+    cur_pid = p;
 
     // create pcb for this process
     pcb_t *pcb;
-    pcb = get_pcb(t[t_visible].running_process);
+    pcb = get_pcb(p);
     pcb_init(pcb);
 
+    // program image is loaded page by page on first touch (see page_in)
+    inode_t* inode = &(inode_arr[search.inode]);
+    pcb->img_inode = search.inode;
+    pcb->img_length = inode->length;
+    pcb->img_pages = 0;
+    pcb->heap_start = image_end(search.inode, inode->length);
+    pcb->brk = pcb->heap_start;
+    exec_pages_total += (inode->length + _4_KB - 1) / _4_KB;
+
+    //set up paging
+    map_program(p);
+
+    t[t_cur].process_ct++;
+
     // check if current process is base shell
-    if(t[t_visible].shell_flag == -1) {
-        t[t_visible].shell_flag = 0;
+    if(t[t_cur].shell_flag == -1) {
+        t[t_cur].shell_flag = 0;
         pcb->parent_pid = pcb->pid;
     } else{
         pcb->parent_pid = parent_process;
+        // stdin and stdout are the caller's, the shell may have pointed them
+        // at a pipe
+        for(i = 0; i < FD_START; ++i) {
+            pcb->fd_table[i] = get_pcb(parent_process)->fd_table[i];
+            pipe_ref(&pcb->fd_table[i]);
+        }
     }
-    pcb->esp0 = _8_MB - _8_KB * pcb->parent_pid - FOUR_BYTE;
+    pcb->esp0 = KSTACK_TOP(pcb->parent_pid);
     pcb->ss0 = KERNEL_DS;
 
     // storing the argument to a buffer in pcb for getargs fn
@@ -176,7 +299,7 @@ int32_t execute (const uint8_t* command) {
     );
 
     // update task segment
-    tss.esp0 = _8_MB - _8_KB * pcb->pid - FOUR_BYTE;
+    tss.esp0 = KSTACK_TOP(pcb->pid);
     tss.ss0 = KERNEL_DS;
 
     context_switch(entry_point);
@@ -195,25 +318,40 @@ int32_t halt (uint8_t status) {
     pcb_t *pcb;
 
     // get current process block and current process' parent block
-    pcb = get_pcb(t[t_visible].running_process);
+    pcb = get_pcb(cur_pid);
 
-    // clear all file descriptors
-    for(i = FD_START; i < FD_MAX; ++i)
-        close(i);
+    // clear all file descriptors, stdin and stdout too since they may hold
+    // a pipe end open
+    for(i = 0; i < FD_MAX; ++i)
+        fd_close(i);
+
+    debugf("pid %d faulted in %d of %d image pages, %d pages resident\n", pcb->pid,
+           pcb->img_pages, (pcb->img_length + _4_KB - 1) / _4_KB, pcb->user_pages);
 
     // free up process, set running process back to parent
-    process_status[t[t_visible].running_process] = -1;
-    t[t_visible].running_process = pcb->parent_pid;
-    t[t_visible].process_ct--;
+    process_status[pcb->pid] = -1;
+    t[t_cur].process_ct--;
+
+    // a forked child has no execute frame to return to, it just goes away
+    if(pcb->forked) {
+        cli();
+        sched_exit();
+    }
+    if(t[t_cur].running_process == pcb->pid)
+        t[t_cur].running_process = pcb->parent_pid;
+    cur_pid = pcb->parent_pid;
 
     // if current process block is base shell, re-execute shell
     if (pcb->parent_pid == pcb->pid){
-        t[t_visible].running_process = -1;
-        t[t_visible].shell_flag = -1;
+        t[t_cur].running_process = -1;
+        t[t_cur].shell_flag = -1;
         execute((uint8_t*)"shell");
     }
     // restore parent paging
     map_program(pcb->parent_pid); // flushes tlb
+    // the child's frames can go now that nothing maps them, its pid too
+    release_program(pcb->pid);
+    pid_release(pcb->pid);
 
     // write parent process' info back to TSS(esp0)
     tss.esp0 = pcb->esp0;
@@ -238,7 +376,7 @@ int32_t halt (uint8_t status) {
  */
 int32_t read (int32_t fd, void* buf, int32_t nbytes) {
     // get a pcb to perform read operation
-    pcb_t *pcb = get_pcb(t[t_visible].running_process);
+    pcb_t *pcb = get_pcb(cur_pid);
 
     // error handling - FD in array, buf not empty, nbytes >= 0
     if(fd >= FD_MAX || fd < 0 || buf == NULL || nbytes < 0 || pcb->fd_table[fd].flags == 0) {
@@ -257,7 +395,7 @@ int32_t read (int32_t fd, void* buf, int32_t nbytes) {
  * return - 0 on success, 1 on failure
  */
 int32_t write (int32_t fd, const void* buf, int32_t nbytes) {
-    pcb_t *pcb = get_pcb(t[t_visible].running_process);
+    pcb_t *pcb = get_pcb(cur_pid);
     // error handling - FD in array, buf not empty, nbytes >= 0
     if(fd >= FD_MAX || fd < 0 || buf == NULL || nbytes < 0 || pcb->fd_table[fd].flags == 0) {
         return -1;
@@ -273,7 +411,7 @@ int32_t write (int32_t fd, const void* buf, int32_t nbytes) {
  * return - 0 on success, 1 on failure
  */
 int32_t open (const uint8_t* filename) {
-    pcb_t *pcb = get_pcb(t[t_visible].running_process);
+    pcb_t *pcb = get_pcb(cur_pid);
 
     // input error handling
     if(filename == NULL || strlen((int8_t*)filename) == 0) {
@@ -298,7 +436,8 @@ int32_t open (const uint8_t* filename) {
             switch(f_type){
                 case RTC_FTYPE:
                     pcb->fd_table[fd].fops_ptr = &fops_rtc;
-                    pcb->fd_table[fd].inode = NULL;
+                    // RTC fds keep their tick divider in inode
+                    pcb->fd_table[fd].inode = RTC_HW_FREQ / RTC_OPEN_FREQ;
                     type_found = 1;
                     break;
                 case DIR_FTYPE:
@@ -328,18 +467,13 @@ int32_t open (const uint8_t* filename) {
     return -1;
 }
 
-/* close - CP3
- * closes specified fd from fd table
- * parameter - filename - name of file in filesystem
- * return - 0 on success, 1 on failure
+/* fd_close - CP5
+ * closes an entry of the running process' fd table, stdin and stdout included
+ * parameter - fd : index into the fd table
+ * return - 0 on success, -1 if it was not open
  */
-int32_t close (int32_t fd) {
-    // error handling - fd index not in array
-    // user cannot close default descriptors
-    if(fd >= FD_MAX || fd < FD_START) {
-        return -1;
-    }
-    pcb_t* pcb = get_pcb(t[t_visible].running_process);
+static int32_t fd_close (int32_t fd) {
+    pcb_t* pcb = get_pcb(cur_pid);
 
     //already not in use we dont need to close
     if(pcb->fd_table[fd].flags == 0){
@@ -347,12 +481,31 @@ int32_t close (int32_t fd) {
     } else {
         pcb->fd_table[fd].flags = 0;
     }
+    // drop the file window if it was backed by this fd
+    if(pcb->fmap_fd == fd) {
+        pcb->fmap_fd = NO_FMAP;
+        unmap_file(pcb->pid);
+    }
     // find fd in fd_table and close
     pcb->fd_table[fd].fops_ptr->close(fd);
 
     return 0;
 }
 
+/* close - CP3
+ * closes specified fd from fd table
+ * parameter - filename - name of file in filesystem
+ * return - 0 on success, 1 on failure
+ */
+int32_t close (int32_t fd) {
+    // error handling - fd index not in array
+    // user cannot close default descriptors
+    if(fd >= FD_MAX || fd < FD_START) {
+        return -1;
+    }
+    return fd_close(fd);
+}
+
 /* getargs - CP3
  * copies arguments passed in from execute in the pcb into a user-level buffer
  * parameter - buf : user level buffer that we copy the data into
@@ -360,7 +513,7 @@ int32_t close (int32_t fd) {
  * return - 0 on success, -1 on failure
  */
 int32_t getargs (uint8_t* buf, int32_t nbytes) {
-    pcb_t* pcb = get_pcb(t[t_visible].running_process);
+    pcb_t* pcb = get_pcb(cur_pid);
 
     if(buf == NULL || nbytes <= 0 || pcb->arg == '\0' || strlen((int8_t*)pcb->arg) + 1 > nbytes) {
         return -1;
@@ -384,13 +537,238 @@ int32_t vidmap (uint8_t** screen_start) {
     }
 
     // create page and set screen start to 140MB pointer
-    map_video();
+    if(map_video() == -1) {
+        return -1;
+    }
     *screen_start = (uint8_t*) _140_MB;
 
     return 0;
 
 }
 
+/* mmap - CP5
+ * maps the data blocks of an open file read-only into user space at virtual
+ * address 144MB, so the file can be scanned without copying through read.
+ * Only one file is mapped at a time, mapping another replaces it. If the
+ * file can not be mapped the caller should fall back to read.
+ * parameter - fd : open file descriptor of a regular file
+ *             start : set to 144MB on success
+ * return - length of the file on success, -1 on failure
+ */
+int32_t mmap (int32_t fd, uint8_t** start) {
+    pcb_t* pcb = get_pcb(cur_pid);
+
+    if(start == NULL || start < (uint8_t**)_128_MB || start > (uint8_t**)(_132_MB - FOUR_BYTE)) {
+        return -1;
+    }
+    if(fd >= FD_MAX || fd < FD_START || pcb->fd_table[fd].flags == 0 || pcb->fd_table[fd].fops_ptr != &fops_file) {
+        return -1;
+    }
+    if(map_file(pcb->pid, pcb->fd_table[fd].inode) == -1) {
+        return -1;
+    }
+
+    pcb->fmap_fd = fd;
+    *start = (uint8_t*) _144_MB;
+    return inode_arr[pcb->fd_table[fd].inode].length;
+}
+
+/* fork - CP5
+ * Creates a copy of the running process without reloading its image. The
+ * child gets the parent's open files and shares its program pages
+ * copy-on-write (see fork_program). It is queued to run and resumes from
+ * this same system call on a copy of the parent's system call frame.
+ * parameter - none
+ * return - the child's pid to the parent and 0 to the child, -1 on failure
+ */
+int32_t fork (void) {
+    int32_t p, i;
+    uint32_t flags;
+    uint32_t *src, *dst;
+    pcb_t *parent, *child;
+
+    if(cur_pid < 0) {
+        return -1;
+    }
+    cli_and_save(flags);
+    parent = get_pcb(cur_pid);
+    if((p = pid_alloc()) == NO_PID) {
+        restore_flags(flags);
+        return -1;
+    }
+    if((child = pcb_alloc(p)) == NULL || fork_program(cur_pid, p) == -1) {
+        pid_release(p);
+        restore_flags(flags);
+        return -1;
+    }
+
+    memcpy(child->fd_table, parent->fd_table, sizeof(parent->fd_table));
+    for(i = 0; i < FD_MAX; ++i)
+        pipe_ref(&child->fd_table[i]);
+    memcpy(child->arg, parent->arg, sizeof(parent->arg));
+    child->pid = p;
+    child->parent_pid = parent->pid;
+    child->tid = parent->tid;
+    child->forked = 1;
+    child->fmap_fd = parent->fmap_fd;
+    child->img_inode = parent->img_inode;
+    child->img_length = parent->img_length;
+    child->img_pages = 0;
+    child->heap_start = parent->heap_start;
+    child->brk = parent->brk;
+
+    // copy the user registers the linkage saved, kstack_switch "returns"
+    // into fork_ret which pops them with EAX = 0
+    src = (uint32_t*)KSTACK_TOP(cur_pid) - SYSCALL_FRAME_WORDS;
+    dst = (uint32_t*)KSTACK_TOP(p) - SYSCALL_FRAME_WORDS;
+    memcpy(dst, src, SYSCALL_FRAME_WORDS * FOUR_BYTE);
+    // frame popped by kstack_switch: edi, esi, ebx, ebp, eflags, return address
+    dst[-1] = (uint32_t)fork_ret;
+    dst[-2] = EFLAGS_BASE;
+    dst[-3] = 0;
+    dst[-4] = 0;
+    dst[-5] = 0;
+    dst[-6] = 0;
+    child->ksp = (uint32_t)&dst[-6];
+
+    process_status[p] = child->tid;
+    t[child->tid].process_ct++;
+    rq_push(p);
+    restore_flags(flags);
+    return p;
+}
+
+/* sbrk - CP5
+ * Moves the end of the heap, which starts after the program's bss and can
+ * grow to the end of the program window. New heap pages are zero filled
+ * on first touch, pages the heap gives up are freed.
+ * parameter - increment : bytes to add, negative to shrink
+ * return - the old end of the heap, -1 on failure
+ */
+int32_t sbrk (int32_t increment) {
+    pcb_t* pcb = get_pcb(cur_pid);
+    uint32_t old = pcb->brk;
+    uint32_t new_brk = old + increment;
+
+    if(increment > 0 && (new_brk < old || new_brk > _132_MB)) {
+        return -1;
+    }
+    if(increment < 0 && (new_brk > old || new_brk < pcb->heap_start)) {
+        return -1;
+    }
+    if(increment < 0) {
+        unmap_user(cur_pid, (new_brk + _4_KB - 1) & ~(_4_KB - 1), old);
+    }
+    pcb->brk = new_brk;
+    return old;
+}
+
+/* mmap_anon - CP5
+ * Maps zero filled memory at virtual address 148MB and up, for blocks too
+ * big for the heap to hand back. Pages get a frame on first touch.
+ * parameter - length : bytes needed, rounded up to whole pages
+ *             start : where the address of the memory is written
+ * return - 0 on success, -1 on failure
+ */
+int32_t mmap_anon (uint32_t length, uint8_t** start) {
+    uint32_t addr;
+
+    if(start == NULL || start < (uint8_t**)_128_MB || start > (uint8_t**)(_132_MB - FOUR_BYTE)) {
+        return -1;
+    }
+    if(length == 0 || length > _4_MB) {
+        return -1;
+    }
+    if((addr = map_anon(cur_pid, (length + _4_KB - 1) / _4_KB)) == 0) {
+        return -1;
+    }
+    *start = (uint8_t*)addr;
+    return 0;
+}
+
+/* munmap - CP5
+ * Unmaps memory from mmap_anon or shm_map, its pages can be mapped again
+ * parameter - start : page aligned address from mmap_anon or shm_map
+ *             length : bytes to unmap, rounded up to whole pages
+ * return - 0 on success, -1 on failure
+ */
+int32_t munmap (uint8_t* start, uint32_t length) {
+    uint32_t addr = (uint32_t)start;
+
+    if((addr & (_4_KB - 1)) || addr < _148_MB || addr >= _148_MB + _4_MB ||
+       length > _148_MB + _4_MB - addr) {
+        return -1;
+    }
+    unmap_user(cur_pid, addr, addr + length);
+    return 0;
+}
+
+/* ring_setup - CP5
+ * Maps the process' system call ring (a zeroed syscall_ring_t) next to the
+ * vidmap page. Calling it again gives the same ring.
+ * parameter - ring : where the ring's address is written
+ * return - 0 on success, -1 on failure
+ */
+int32_t ring_setup (uint8_t** ring) {
+    if(ring == NULL || ring < (uint8_t**)_128_MB || ring > (uint8_t**)(_132_MB - FOUR_BYTE)) {
+        return -1;
+    }
+    if(map_ring(cur_pid) == -1) {
+        return -1;
+    }
+    *ring = (uint8_t*)RING_ADDR;
+    return 0;
+}
+
+/* ring_enter - CP5
+ * Runs queued ring submissions in order through the usual system calls, so
+ * they go through the same fd checks and file_ops_t dispatch, and posts a
+ * completion for each. Stops early when the completion queue is full. A
+ * blocking call (terminal read) blocks the whole batch.
+ * parameter - count : most submissions to run
+ * return - number of submissions run, -1 if the process has no ring
+ */
+int32_t ring_enter (uint32_t count) {
+    syscall_ring_t* ring = get_pcb(cur_pid)->ring;
+    ring_sqe_t sqe;
+    ring_cqe_t* cqe;
+    int32_t result;
+    uint32_t done;
+
+    if(ring == NULL) {
+        return -1;
+    }
+    for(done = 0; done < count && ring->sq_head != ring->sq_tail; ++done) {
+        if(ring->cq_tail - ring->cq_head >= RING_ENTRIES) {
+            break;
+        }
+        // copied first, the process can reuse the slot once sq_head moves
+        sqe = ring->sq[ring->sq_head % RING_ENTRIES];
+        ring->sq_head++;
+        switch(sqe.op) {
+            case SYS_READ_NR:
+                result = read(sqe.arg[0], (void*)sqe.arg[1], sqe.arg[2]);
+                break;
+            case SYS_WRITE_NR:
+                result = write(sqe.arg[0], (const void*)sqe.arg[1], sqe.arg[2]);
+                break;
+            case SYS_OPEN_NR:
+                result = open((const uint8_t*)sqe.arg[0]);
+                break;
+            case SYS_CLOSE_NR:
+                result = close(sqe.arg[0]);
+                break;
+            default:
+                result = -1;
+        }
+        cqe = &ring->cq[ring->cq_tail % RING_ENTRIES];
+        cqe->user_data = sqe.user_data;
+        cqe->result = result;
+        ring->cq_tail++;
+    }
+    return done;
+}
+
 /* set_handler - CP3
  * Not used yet.
  * parameter - signum :
@@ -409,3 +787,87 @@ int32_t set_handler (int32_t signum, void* handler_address) {
 int32_t sigreturn (void) {
     return -1;
 }
+
+/* pipe - CP5
+ * Creates a pipe and opens both of its ends in the two lowest free fds.
+ * Reads block until a writer supplies data and return 0 once every write
+ * end is closed, writes block while the pipe is full (see pipe.c). The ends
+ * are carried over by fork, dup2 and execute's stdin and stdout.
+ * parameter - fds : fds[0] gets the read end, fds[1] the write end
+ * return - 0 on success, -1 on failure
+ */
+int32_t pipe (int32_t* fds) {
+    pcb_t* pcb = get_pcb(cur_pid);
+    int32_t rd, wr;
+
+    if(fds == NULL || fds < (int32_t*)_128_MB || fds > (int32_t*)(_132_MB - 2 * FOUR_BYTE)) {
+        return -1;
+    }
+    for(rd = FD_START; rd < FD_MAX && pcb->fd_table[rd].flags; ++rd);
+    for(wr = rd + 1; wr < FD_MAX && pcb->fd_table[wr].flags; ++wr);
+    if(wr >= FD_MAX || pipe_create(&pcb->fd_table[rd], &pcb->fd_table[wr]) == -1) {
+        return -1;
+    }
+    fds[0] = rd;
+    fds[1] = wr;
+    return 0;
+}
+
+/* dup2 - CP5
+ * Makes newfd refer to the same file as oldfd, closing whatever newfd had
+ * open first. Unlike close this may replace stdin and stdout, which is how
+ * a pipeline stage gets a pipe as its input or output. A copied file keeps
+ * its own position.
+ * parameter - oldfd : open fd to copy
+ *             newfd : fd to replace
+ * return - newfd on success, -1 on failure
+ */
+int32_t dup2 (int32_t oldfd, int32_t newfd) {
+    pcb_t* pcb = get_pcb(cur_pid);
+
+    if(oldfd < 0 || oldfd >= FD_MAX || newfd < 0 || newfd >= FD_MAX || pcb->fd_table[oldfd].flags == 0) {
+        return -1;
+    }
+    if(oldfd == newfd) {
+        return newfd;
+    }
+    fd_close(newfd);
+    pcb->fd_table[newfd] = pcb->fd_table[oldfd];
+    pipe_ref(&pcb->fd_table[newfd]);
+    return newfd;
+}
+
+/* shm_map - CP5
+ * Maps a named shared memory segment into the anonymous memory window,
+ * creating it zero filled if no process maps that name. Every process that
+ * maps the name, at whatever address, shares the same frames, so
+ * cooperating programs can exchange data without a system call per
+ * message. A forked child keeps sharing the parent's mappings. munmap
+ * removes a mapping, the segment goes away with its last one.
+ * parameter - name : segment name, shorter than SHM_NAME_LEN
+ *             length : bytes to map, rounded up to whole pages, at most the
+ *                      size of an existing segment
+ *             start : holds the address to map at, or NULL for any free
+ *                     range, and gets the address of the mapping
+ * return - 0 on success, -1 on failure
+ */
+int32_t shm_map (const uint8_t* name, uint32_t length, uint8_t** start) {
+    shm_seg_t* seg;
+    uint32_t addr, pages;
+
+    if(name == NULL || start == NULL || start < (uint8_t**)_128_MB || start > (uint8_t**)(_132_MB - FOUR_BYTE)) {
+        return -1;
+    }
+    if(length == 0 || length > _4_MB) {
+        return -1;
+    }
+    pages = (length + _4_KB - 1) / _4_KB;
+    if((seg = shm_get((const int8_t*)name, pages)) == NULL) {
+        return -1;
+    }
+    if((addr = map_shared(cur_pid, (uint32_t)*start, seg->frames, pages)) == 0) {
+        return -1;
+    }
+    *start = (uint8_t*)addr;
+    return 0;
+}
@@ -10,23 +10,45 @@
 #include "system_calls_wrapper.h"
 #include "scheduler.h"
 #include "idt_handlers.h"
+#include "debug.h"
 
 #define PROG_IMG_ADDR        0x8048000
-#define PROCESS_COUNT        6
-#define MAX_PROC_PER_TERM    3
+// size of the pid table, process_limit lowers it to what RAM can hold
+#define PROCESS_COUNT        1024
+// frames a process needs at least: the kernel stack, the page directory
+// and program page table, and a page each of code and user stack. Anything
+// else is demand paged and fails at fault time once memory runs out.
+#define KSTACK_FRAMES        2
+#define PROC_FRAMES          (KSTACK_FRAMES + 4)
 
 #define ENTRY_POINT_START    24
+// ELF header and program header fields used to find the end of the bss
+#define ELF_PHOFF            28
+#define ELF_PHNUM            44
+#define ELF_PHENTSIZE        42
+#define PH_TYPE              0
+#define PH_VADDR             8
+#define PH_MEMSZ             20
+#define PT_LOAD              1
 #define CMD_MAX_LEN          32
 
 #define FOUR_BYTE            4
 #define MAX_KBUFF_LEN        128
 
+// kernel stack of a process starts at the top of its 8KB block
+#define KSTACK_TOP(pid)      ((uint32_t)get_pcb(pid) + _8_KB - FOUR_BYTE)
+
 #define FD_START             2
 #define FD_MAX               8
 
 #define RTC_FTYPE            0
 #define DIR_FTYPE            1
 #define FILE_FTYPE           2
+#define NO_FMAP              -1
+
+// words the system call linkage has on the kernel stack when it calls the
+// handler: the iret frame (5), pushfl (1) and pushal (8)
+#define SYSCALL_FRAME_WORDS  14
 
 // file operations containing pointers to functions for that type of file
 typedef struct __attribute__((packed)) {
@@ -39,11 +61,43 @@ typedef struct __attribute__((packed)) {
 // file descriptor - used in PCB to store FDs
 typedef struct __attribute__((packed)) {
     file_ops_t *fops_ptr;
-    uint32_t inode;
+    uint32_t inode;    // for RTC fds: hardware ticks per virtual tick
     uint32_t file_pos;
     uint32_t flags;
 } file_desc_t;
 
+// system call ring shared with a process (ring_setup). The process
+// fills submissions at sq_tail, ring_enter runs them from sq_head and posts
+// completions at cq_tail, the process reaps them from cq_head. Indices only
+// grow, entries are at index % RING_ENTRIES.
+#define RING_ENTRIES         64
+
+typedef struct __attribute__((packed)) {
+    uint32_t op;        // SYS_READ, SYS_WRITE, SYS_OPEN or SYS_CLOSE number
+    int32_t arg[3];     // arguments as the system call takes them
+    uint32_t user_data; // handed back in the completion
+} ring_sqe_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t user_data;
+    int32_t result;     // return value of the call
+} ring_cqe_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    ring_sqe_t sq[RING_ENTRIES];
+    ring_cqe_t cq[RING_ENTRIES];
+} syscall_ring_t;
+
+// system call numbers a ring submission can use
+#define SYS_READ_NR          3
+#define SYS_WRITE_NR         4
+#define SYS_OPEN_NR          5
+#define SYS_CLOSE_NR         6
+
 // PCB
 typedef struct __attribute__((packed)){
     file_desc_t fd_table[FD_MAX];
@@ -51,17 +105,34 @@ typedef struct __attribute__((packed)){
     // get ESP and EBP from address
     uint32_t esp;
     uint32_t ebp;
-    uint32_t cur_esp;
-    uint32_t cur_ebp;
+    uint32_t ksp; // kernel esp saved by kstack_switch while not running
+    int32_t tid;  // terminal the process belongs to
+    int32_t wait_next; // next pid on the wait queue this process sleeps on
     uint32_t pid;
     uint32_t parent_pid; // we may need this?
+    int32_t forked; // created by fork, halt has no parent frame to return to
     uint16_t ss0;
     uint32_t esp0;
     uint8_t arg[MAX_KBUFF_LEN];
+    int32_t fmap_fd; // fd mapped at 144MB by mmap, NO_FMAP if none
+    uint32_t img_inode; // program image, loaded page by page on fault
+    uint32_t img_length;
+    uint32_t img_pages; // pages of the image faulted in so far
+    uint32_t* page_dir;   // the process' own page directory (frame allocator)
+    uint32_t* prog_table; // page table of the program window
+    uint32_t* fmap_table; // page table of the file window, NULL until mmap
+    uint32_t* vid_table;  // page table of the vidmap and ring pages, NULL until used
+    syscall_ring_t* ring; // system call ring page, NULL until ring_setup
+    uint32_t* anon_table; // page table of the anonymous mmap window, NULL until used
+    uint32_t user_pages;  // user pages with a frame
+    uint32_t heap_start;  // end of the image's bss, sbrk can't go below it
+    uint32_t brk;         // end of the heap
 } pcb_t;
 
-// array of free processes. -1 if free, otherwise stores terminal id (only 1 for now)
+// array of free processes. -1 if free, otherwise stores terminal id
 int process_status[PROCESS_COUNT];
+// number of pids in use at most, set at boot from the free frames
+extern uint32_t process_limit;
 
 // file operations set for rtc
 extern file_ops_t fops_rtc;
@@ -74,8 +145,16 @@ extern file_ops_t std_in;
 // file operations set for terminal write
 extern file_ops_t std_out;
 
+// sizes the process table to the installed RAM, marks every pid free
+extern void process_init(void);
 // gets the pcb address of where the given pid is
 extern pcb_t* get_pcb(int pid_in);
+// takes a free pid, NO_PID if there is none
+extern int32_t pid_alloc(void);
+// frees the pid of a finished process
+extern void pid_release(int pid_in);
+// gives a pid its pcb and kernel stack if it has none yet
+extern pcb_t* pcb_alloc(int pid_in);
 // place holder for non-existent system calls in the function jumptable
 extern int32_t bad_call();
 // After execute is called, must call halt. Halts the program.
@@ -94,6 +173,26 @@ extern int32_t close (int32_t fd);
 extern int32_t getargs (uint8_t* buf, int32_t nbytes);
 // maps text mode video memory into user space at virtual address 140MB and creates page
 extern int32_t vidmap (uint8_t** screen_start);
+// maps a file read-only into user space at virtual address 144MB
+extern int32_t mmap (int32_t fd, uint8_t** start);
+// creates a copy-on-write copy of the running process
+extern int32_t fork (void);
+// moves the end of the heap, returns the old end
+extern int32_t sbrk (int32_t increment);
+// maps zero filled anonymous memory
+extern int32_t mmap_anon (uint32_t length, uint8_t** start);
+// unmaps anonymous memory
+extern int32_t munmap (uint8_t* start, uint32_t length);
+// maps a system call ring into user space
+extern int32_t ring_setup (uint8_t** ring);
+// runs the queued submissions of the ring
+extern int32_t ring_enter (uint32_t count);
+// creates a pipe, fds gets its read and write end
+extern int32_t pipe (int32_t* fds);
+// makes newfd a copy of oldfd
+extern int32_t dup2 (int32_t oldfd, int32_t newfd);
+// maps a named shared memory segment
+extern int32_t shm_map (const uint8_t* name, uint32_t length, uint8_t** start);
 // not used
 extern int32_t set_handler (int32_t signum, void* handler_address);
 // not used
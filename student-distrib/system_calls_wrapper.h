@@ -5,5 +5,13 @@
 extern void context_switch(uint32_t entry_point);
 // 
 extern void halt_ret(uint32_t esp, uint32_t ebp, uint32_t status);
+// saves the kernel context to *save_esp and resumes the one at next_esp
+extern void kstack_switch(void* save_esp, uint32_t next_esp);
+// where a forked child starts, returns 0 from fork to user space
+extern void fork_ret(void);
+// system call entry for sysenter
+extern void sysenter_handler_link(void);
+// ESP loaded by sysenter before the handler picks the process' stack
+extern uint32_t sysenter_entry_esp;
 
 #endif
@@ -1,15 +1,17 @@
 #include "terminal.h"
-static char* video_mem = (char *)VID_MEM;
 
-/* void clear_buffer(void);
- * Inputs: void
+// ring of lines per terminal, the screen is the NUM_ROWS lines from t.top
+static uint16_t scrollback[TERMINAL_COUNT][SCROLLBACK_LINES][NUM_COLS];
+
+/* void clear_buffer(int32_t tid);
+ * Inputs: tid -- terminal whose line buffer is cleared
  * Return Value: none
  * Function: Clears terminal buffer */
-void clear_buffer(void) {
+void clear_buffer(int32_t tid) {
     int32_t i;
     for (i = 0; i < BUF_SIZE; ++i)
-        t[t_visible].buffer[i] = '\0';
-    t[t_visible].buffer_idx = 0;
+        t[tid].buffer[i] = '\0';
+    t[tid].buffer_idx = 0;
 }
 
 /* void terminal_init(void);
@@ -21,12 +23,38 @@ void terminal_init(void) {
     for(i = 0; i < TERMINAL_COUNT; i++) {
         t[i].running_process = -1;
         t[i].shell_flag = -1;
-        t[i].video_mem = (char*)(VID_MEM + (i+1) * _4_KB); //xb9000, xba000, xbb000
+        t[i].video_mem = (char*)TERM_VID(i); //xb8000, xb9000, xba000
+        t[i].top = 0;
+        t[i].history = 0;
+        term_clear(i);
     }
 
+    set_display_start(t_visible);
     terminal_reset();
 }
 
+/* char* term_video(int32_t tid);
+ * Inputs: tid -- terminal to draw on
+ * Return Value: video memory the terminal's output goes to
+ * Function: every terminal draws on its own page of VGA memory, visible or
+ *           not, switch_display just changes which page is shown */
+char* term_video(int32_t tid) {
+    return (char*)TERM_VID(tid);
+}
+
+/* void set_display_start(int32_t tid);
+ * Inputs: tid -- terminal to show
+ * Return Value: none
+ * Function: points the CRTC start address registers (in character cells)
+ *           at the terminal's page of video memory */
+void set_display_start(int32_t tid) {
+    uint16_t start = tid * TERM_VID_CELLS;
+    outb(START_ADDR_HIGH, VGA_CTRL);
+    outb((uint8_t)((start >> TWO_BYTE) & TWO_BYTE_MASK), VGA_DATA);
+    outb(START_ADDR_LOW, VGA_CTRL);
+    outb((uint8_t)(start & TWO_BYTE_MASK), VGA_DATA);
+}
+
 /* int32_t terminal_open;
  * Inputs: filename -- unused
  * Return Value: none
@@ -41,7 +69,7 @@ int32_t terminal_open(const uint8_t *filename) {
  * Return Value: none
  * Function: close terminal and make it available for later */
 int32_t terminal_close(int32_t fd) {
-    clear_buffer();
+    clear_buffer(t_cur);
     return -1;
 }
 
@@ -51,8 +79,8 @@ int32_t terminal_close(int32_t fd) {
  * Function: Clear the screen and put the cursor at the top */
 void terminal_reset(void) {
     t[t_visible].screen_x = 0, t[t_visible].screen_y = 0;
-    clear();
-    clear_buffer();
+    term_clear(t_visible);
+    clear_buffer(t_visible);
     update_cursor();
 }
 
@@ -63,7 +91,8 @@ void terminal_reset(void) {
  * function implementation copied from https://wiki.osdev.org/Text_Mode_Cursor
  * description from https://stackoverflow.com/questions/25321608/moving-text-mode-cursor-not-working */
 void update_cursor(void) {
-    uint16_t position = t[t_visible].screen_y * NUM_COLS + t[t_visible].screen_x; // hold two 8 bits -> 16 bits
+    // the cursor address counts from the start of video memory, not the display start
+    uint16_t position = t_visible * TERM_VID_CELLS + t[t_visible].screen_y * NUM_COLS + t[t_visible].screen_x; // hold two 8 bits -> 16 bits
     // update lower 2 bytes
     outb(CURSOR_LOW, VGA_CTRL);
     outb((uint8_t)(position & TWO_BYTE_MASK), VGA_DATA);
@@ -78,24 +107,25 @@ void update_cursor(void) {
            buf -- address of the data to be sent
  * Outputs:
  * Return Value: size -- the number of chars in buffer
- * Function: read (copy) the content of the line buffer to the given buffer */
+ * Function: read (copy) the content of the calling process' terminal line
+ *           buffer to the given buffer */
 int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes) {
     if (!buf || nbytes < 0) return -1;
     int32_t i, size;
+    int32_t tid = t_cur;
 
-    clear_buffer();
-    sti();
-    // wait until the buffer reaches its max size or the enter is pressed
-    while(t[t_visible].buffer_idx < BUF_SIZE - 1 && !get_enter_flag());
     cli();
+    clear_buffer(tid);
+    // sleep until the buffer reaches its max size or the enter is pressed
+    wait_for_line(tid);
     // size should be the min of nbytes or the buffer_idx
-    size = nbytes > t[t_visible].buffer_idx ? t[t_visible].buffer_idx : nbytes;
+    size = nbytes > t[tid].buffer_idx ? t[tid].buffer_idx : nbytes;
     for (i = 0; i < size; ++i) {
-        ((int8_t*)buf)[i] = t[t_visible].buffer[i];
+        ((int8_t*)buf)[i] = t[tid].buffer[i];
     }
     // release the enter
-    release_enter();
-    clear_buffer();
+    release_enter(tid);
+    clear_buffer(tid);
     return size;
 }
 
@@ -109,25 +139,59 @@ int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes) {
     if (buf == NULL || nbytes < 0)
         return -1;
 
-    int32_t i;
-    // write on the terminal
-    for (i = 0; i < nbytes; ++i)
-        putc(((uint8_t *)buf)[i]);
+    // write on the terminal, one pass and one cursor update for the buffer
+    return putn((const uint8_t*)buf, nbytes);
+}
 
-    return nbytes;
+/* uint16_t* term_line(int32_t tid, uint32_t y);
+ * Inputs: tid -- terminal
+ *         y -- screen row
+ * Return Value: the NUM_COLS cells of that row in the scrollback ring
+ * Function: maps a screen row to its line in the ring */
+uint16_t* term_line(int32_t tid, uint32_t y) {
+    return scrollback[tid][(t[tid].top + y) & SCROLLBACK_MASK];
 }
 
-/* void scroll_up(void);
- * Inputs: void
+/* void term_blit(int32_t tid);
+ * Inputs: tid -- terminal to draw
  * Return Value: none
- * Function: delete the first line and move everything up a line */
-void scroll_up(void) {
-    int32_t i;
-    // move everything up a line
-    memmove(video_mem, video_mem + (NUM_COLS << 1), (NUM_COLS * (NUM_ROWS - 1)) << 1);
-    // clear the last line
-    for (i = (NUM_ROWS - 1) * NUM_COLS; i < NUM_ROWS * NUM_COLS; ++i) {
-        *(uint8_t *)(video_mem + (i << 1))     = ' ';
-        *(uint8_t *)(video_mem + (i << 1) + 1) = ATTRIB;
-    }
+ * Function: copies the NUM_ROWS lines the terminal shows, the live screen
+ *           or a window into its history, from the ring to its video page */
+void term_blit(int32_t tid) {
+    uint32_t y;
+    uint32_t first = t[tid].top - t[tid].view;
+    uint16_t* mem = (uint16_t*)term_video(tid);
+    for (y = 0; y < NUM_ROWS; y++)
+        memcpy(mem + y * NUM_COLS, scrollback[tid][(first + y) & SCROLLBACK_MASK], NUM_COLS << 1);
+}
+
+/* void term_scrollback(int32_t tid, int32_t lines);
+ * Inputs: tid -- terminal to scroll
+ *         lines -- lines to move back into the history, negative moves
+ *                  towards the live screen
+ * Return Value: none
+ * Function: Shift+PageUp/PageDown history browsing, the view is clamped to
+ *           the lines the ring still holds */
+void term_scrollback(int32_t tid, int32_t lines) {
+    int32_t view = (int32_t)t[tid].view + lines;
+    if (view < 0)
+        view = 0;
+    if (view > (int32_t)t[tid].history)
+        view = t[tid].history;
+    if (view == t[tid].view)
+        return;
+    t[tid].view = view;
+    term_blit(tid);
+}
+
+/* void scroll_up(int32_t tid);
+ * Inputs: tid -- terminal to scroll
+ * Return Value: none
+ * Function: the top line goes into the history by advancing the ring, only
+ *           the new bottom line is cleared. Callers redraw the video page. */
+void scroll_up(int32_t tid) {
+    t[tid].top = (t[tid].top + 1) & SCROLLBACK_MASK;
+    if (t[tid].history < SCROLLBACK_LINES - NUM_ROWS)
+        t[tid].history++;
+    memset_word(term_line(tid, NUM_ROWS - 1), (ATTRIB << 8) | ' ', NUM_COLS);
 }
@@ -8,6 +8,8 @@
 // cursor related macros (VGA registers)
 #define CURSOR_LOW      0x0F
 #define CURSOR_HIGH     0x0E
+#define START_ADDR_HIGH 0x0C
+#define START_ADDR_LOW  0x0D
 #define VGA_CTRL        0x3D4
 #define VGA_DATA        0x3D5
 // Terminal related macro and data structure
@@ -17,7 +19,14 @@
 #define TWO_BYTE        8
 
 #define TERMINAL_COUNT  3
-#define PROCESS_COUNT   6
+
+// lines of history each terminal keeps, a power of two
+#define SCROLLBACK_LINES    512
+#define SCROLLBACK_MASK     (SCROLLBACK_LINES - 1)
+
+// terminal tid draws on the tid-th 4KB page of text mode video memory
+#define TERM_VID(tid)   (VID_MEM + (tid) * _4_KB)
+#define TERM_VID_CELLS  (_4_KB >> 1)
 
 typedef struct __attribute__((packed)) terminal {
     uint32_t screen_x;
@@ -25,6 +34,10 @@ typedef struct __attribute__((packed)) terminal {
 
     char* video_mem;
 
+    uint32_t top;       // scrollback line shown on screen row 0
+    uint32_t history;   // lines kept above the screen
+    uint32_t view;      // lines scrolled back into the history, 0 if live
+
     uint8_t buffer[BUF_SIZE];
     uint32_t buffer_idx;
 
@@ -48,7 +61,7 @@ void terminal_reset(void);
 // Initialize terminal
 void terminal_init(void);
 // Clears terminal buffer
-void clear_buffer(void);
+void clear_buffer(int32_t tid);
 
 // Open the terminal and display it
 int32_t terminal_open(const uint8_t *filename);
@@ -60,8 +73,18 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes);
 // Read the content of the given buffer and write on the terminal
 int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes);
 
+// Video memory a terminal draws on, on screen while it is visible
+char* term_video(int32_t tid);
+// Show a terminal's page of video memory on the screen
+void set_display_start(int32_t tid);
+// Scrollback line that holds a screen row of a terminal
+uint16_t* term_line(int32_t tid, uint32_t y);
+// Draw the terminal's visible window of the scrollback onto its video page
+void term_blit(int32_t tid);
+// Move a terminal's view into its history, positive is older
+void term_scrollback(int32_t tid, int32_t lines);
 // Delete the first line and move everything up a line
-void scroll_up(void);
+void scroll_up(int32_t tid);
 // Update the cursor position
 void update_cursor(void);
 
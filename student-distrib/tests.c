@@ -4,6 +4,9 @@
 #include "rtc.h"
 #include "terminal.h"
 #include "filesys.h"
+#include "paging.h"
+#include "frame.h"
+#include "kmalloc.h"
 
 #define PASS 1
 #define FAIL 0
@@ -340,6 +343,36 @@ int list_dir_test() {
 	return PASS;
 }
 
+/* dentry_index_test - CP2
+ * DESCRIPTION: Looks up every directory entry by its own name (including the
+ *              32 char name with no terminator) and checks the index returns
+ *              the same dentry. Also checks too long and empty names fail.
+ * INPUTS: none
+ * OUTPUTS: none
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: none
+ */
+int dentry_index_test() {
+	TEST_HEADER;
+	uint32_t i;
+	uint8_t name[NAME_SIZE + 1];
+	dentry_t by_index, by_name;
+	for(i = 0; i < boot->num_of_dirE; i++) {
+		read_dentry_by_index(i, &by_index);
+		strncpy((int8_t*)name, (int8_t*)by_index.file_name, NAME_SIZE);
+		name[NAME_SIZE] = '\0';
+		if(read_dentry_by_name(name, &by_name) == -1)
+			return FAIL;
+		if(by_name.inode != by_index.inode || by_name.file_type != by_index.file_type)
+			return FAIL;
+	}
+	if(read_dentry_by_name((uint8_t*)"verylargetextwithverylongname.txt", &by_name) != -1)
+		return FAIL;
+	if(read_dentry_by_name((uint8_t*)"", &by_name) != -1)
+		return FAIL;
+	return PASS;
+}
+
 /* Checkpoint 3 tests */
 /* Checkpoint 4 tests */
 
@@ -362,6 +395,696 @@ int video_paging_test() {
 
 /* Checkpoint 5 tests */
 
+/* rtc_virtual_test - CP5
+ * DESCRIPTION: sets a few virtual frequencies and checks each read blocks for
+ *              exactly the matching number of 1024Hz hardware ticks, and that
+ *              the hardware rate is left alone.
+ * INPUTS: none
+ * OUTPUTS: none
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: waits about a second on the RTC
+ */
+int rtc_virtual_test() {
+	TEST_HEADER;
+
+	int32_t freqs[] = {2, 32, 512, 1024};
+	uint32_t i, j, start;
+	int rtc = rtc_open(0);
+
+	for(i = 0; i < sizeof(freqs) / sizeof(freqs[0]); i++) {
+		if(rtc_write(rtc, &freqs[i], INT_BYTES) != INT_BYTES)
+			return FAIL;
+		// first read lines up with a virtual tick
+		rtc_read(rtc, 0, 0);
+		start = rtc_ticks;
+		for(j = 0; j < NUM_READ_INTS / 2; j++)
+			rtc_read(rtc, 0, 0);
+		if(rtc_ticks - start != (RTC_HW_FREQ / freqs[i]) * (NUM_READ_INTS / 2))
+			return FAIL;
+	}
+	// hardware rate still 1024Hz
+	outb(NMI_REG_A, SELECT_REG);
+	if((inb(DATA_REG) & ~HIGH_BIT_MASK) != RTC_HW_RATE)
+		return FAIL;
+	sti();
+	rtc_close(rtc);
+	return PASS;
+}
+
+
+/* Benchmarks */
+
+#define BENCH_ITERS 1000
+
+/* linear_dentry_lookup
+ * DESCRIPTION: the old read_dentry_by_name scan, kept as a baseline for
+ *              dentry_lookup_bench
+ * INPUTS: fname, dentry
+ * RETURN VALUE: 0 (success), -1 (failure)
+ */
+static int32_t linear_dentry_lookup(const uint8_t* fname, dentry_t* dentry) {
+	int i;
+	int name_len = strlen((int8_t*)fname);
+	if(name_len > NAME_SIZE) return -1;
+	if(name_len != NAME_SIZE) name_len += 1;
+	for(i = 0; i < MAX_FILE_COUNT; i++) {
+		if(strncmp((int8_t*)fname, (int8_t*)boot->dir_entries[i].file_name, name_len) == 0) {
+			*dentry = boot->dir_entries[i];
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/* dentry_lookup_bench
+ * DESCRIPTION: times BENCH_ITERS lookups of every file in the directory plus
+ *              one missing name, with the hashed index and the linear scan
+ * INPUTS: none
+ * OUTPUTS: average cycles per lookup for each method
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: none
+ */
+int dentry_lookup_bench() {
+	TEST_HEADER;
+	uint32_t i, j, start, hashed, linear, lookups;
+	uint8_t names[MAX_FILE_COUNT + 1][NAME_SIZE + 1];
+	dentry_t dentry;
+	uint32_t count = boot->num_of_dirE;
+
+	for(j = 0; j < count; j++) {
+		strncpy((int8_t*)names[j], (int8_t*)boot->dir_entries[j].file_name, NAME_SIZE);
+		names[j][NAME_SIZE] = '\0';
+	}
+	strcpy((int8_t*)names[count], (int8_t*)"fakefile.txt"); // worst case for the scan
+	lookups = BENCH_ITERS * (count + 1);
+
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++)
+		for(j = 0; j <= count; j++)
+			read_dentry_by_name(names[j], &dentry);
+	hashed = rdtsc() - start;
+
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++)
+		for(j = 0; j <= count; j++)
+			linear_dentry_lookup(names[j], &dentry);
+	linear = rdtsc() - start;
+
+	printf("dentry lookup: hashed %u cycles, linear %u cycles\n", hashed / lookups, linear / lookups);
+	return PASS;
+}
+
+#define CAT_BENCH_SIZE	(_8_KB)
+static uint8_t cat_bench_buf[CAT_BENCH_SIZE];
+
+/* terminal_write_bench
+ * DESCRIPTION: "cat"s the large text file both with putc per byte (the old
+ *              terminal_write) and with the batched terminal_write, and
+ *              prints cycles per byte for each.
+ * INPUTS: none
+ * OUTPUTS: the file twice, then the timings
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: clears the screen
+ */
+int terminal_write_bench() {
+	TEST_HEADER;
+
+	dentry_t dentry;
+	int32_t len, i;
+	uint32_t start, per_byte, batched;
+
+	if(read_dentry_by_name((uint8_t*)"verylargetextwithverylongname.tx", &dentry) != 0)
+		return FAIL;
+	len = read_data(dentry.inode, 0, cat_bench_buf, CAT_BENCH_SIZE);
+	if(len <= 0)
+		return FAIL;
+
+	start = rdtsc();
+	for(i = 0; i < len; i++)
+		putc(cat_bench_buf[i]);
+	per_byte = rdtsc() - start;
+
+	start = rdtsc();
+	if(terminal_write(1, cat_bench_buf, len) != len)
+		return FAIL;
+	batched = rdtsc() - start;
+
+	terminal_reset();
+	printf("cat %d bytes: putc %u cycles/byte, terminal_write %u cycles/byte\n",
+		len, per_byte / len, batched / len);
+	return PASS;
+}
+
+static uint8_t switch_bench_buf[_4_KB];
+
+/* switch_display_bench
+ * DESCRIPTION: times BENCH_ITERS terminal switches (there and back) with the
+ *              CRTC page flip, and the same number of the old switches that
+ *              copied 4KB out of and 4KB back into video memory
+ * INPUTS: none
+ * OUTPUTS: average cycles per switch for each method
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: none, the visible terminal and the screen are left as they were
+ */
+int switch_display_bench() {
+	TEST_HEADER;
+	uint32_t i, start, flip, copy;
+	int32_t home = t_visible;
+	int32_t other = (home + 1) % TERMINAL_COUNT;
+
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++) {
+		switch_display(other);
+		switch_display(home);
+	}
+	flip = rdtsc() - start;
+	if(t_visible != home)
+		return FAIL;
+
+	start = rdtsc();
+	for(i = 0; i < 2 * BENCH_ITERS; i++) {
+		memcpy(switch_bench_buf, (uint8_t*)VID_MEM, _4_KB);
+		memcpy((uint8_t*)VID_MEM, switch_bench_buf, _4_KB);
+		update_cursor();
+	}
+	copy = rdtsc() - start;
+
+	printf("terminal switch: page flip %u cycles, memcpy %u cycles\n",
+		flip / (2 * BENCH_ITERS), copy / (2 * BENCH_ITERS));
+	return PASS;
+}
+
+/* touch_kernel_pages
+ * DESCRIPTION: reads a word from every kernel mapping a context switch is
+ *              followed by: the kernel page, each 4MB of the direct map
+ *              (pcbs, kernel stacks, page tables) and the terminal pages
+ * INPUTS: none
+ * RETURN VALUE: sum of the words, so the reads are kept
+ */
+static uint32_t touch_kernel_pages() {
+	uint32_t addr, sum = 0;
+	for(addr = _4_MB; addr < frame_top; addr += _4_MB)
+		sum += *(volatile uint32_t*)addr;
+	for(addr = 0; addr < TERMINAL_COUNT; addr++)
+		sum += *(volatile uint32_t*)TERM_VID(addr);
+	return sum;
+}
+
+/* tlb_switch_bench
+ * DESCRIPTION: a context switch reloads CR3. Times BENCH_ITERS CR3 reloads
+ *              followed by touching the kernel mappings, once with global
+ *              pages (kernel entries stay in the TLB) and once with CR4.PGE
+ *              clear (every touch misses)
+ * INPUTS: none
+ * OUTPUTS: average cycles per switch for each, and the saving
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: leaves global pages enabled
+ */
+int tlb_switch_bench() {
+	TEST_HEADER;
+	uint32_t i, start, global, plain;
+
+	set_global_pages(0);
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++) {
+		flush();
+		touch_kernel_pages();
+	}
+	plain = rdtsc() - start;
+
+	set_global_pages(1);
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++) {
+		flush();
+		touch_kernel_pages();
+	}
+	global = rdtsc() - start;
+
+	printf("context switch: global %u cycles, non-global %u cycles, saved %d\n",
+		global / BENCH_ITERS, plain / BENCH_ITERS, (int32_t)(plain - global) / BENCH_ITERS);
+	return PASS;
+}
+
+/* exec_cache_test - CP5
+ * DESCRIPTION: takes the first page of shell from the image cache twice and
+ *              checks both executions get the same frame, holding the file's
+ *              first bytes
+ * INPUTS: none
+ * OUTPUTS: none
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: leaves the page in the image cache
+ */
+int exec_cache_test() {
+	TEST_HEADER;
+	dentry_t dentry;
+	uint8_t magic[FOUR_BYTE];
+	uint32_t first, second;
+	int result = PASS;
+
+	if(read_dentry_by_name((uint8_t*)"shell", &dentry) != 0)
+		return FAIL;
+	read_data(dentry.inode, 0, magic, FOUR_BYTE);
+	first = img_cache_page(dentry.inode, 0);
+	second = img_cache_page(dentry.inode, 0);
+	if(first == 0 || first != second)
+		result = FAIL;
+	else if(strncmp((int8_t*)first, (int8_t*)magic, FOUR_BYTE) != 0)
+		result = FAIL;
+	// drop the references a mapping would have held
+	if(first != 0) frame_free(first);
+	if(second != 0) frame_free(second);
+	return result;
+}
+
+/* kmalloc_test - CP5
+ * DESCRIPTION: allocates objects of every size class, a cache of its own and
+ *              a multi-frame block, checks they don't overlap by filling
+ *              them, frees everything and checks the frames came back
+ * INPUTS: none
+ * OUTPUTS: cache statistics
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: leaves the test cache and one slab per used cache
+ */
+#define KM_TEST_OBJS	64
+int kmalloc_test() {
+	TEST_HEADER;
+	static uint8_t* objs[KM_TEST_OBJS];
+	kmem_cache_t* cache;
+	uint8_t* big;
+	uint32_t i, j, size, free_before;
+	int result = PASS;
+
+	if((cache = kmem_cache_create((int8_t*)"test-obj", 200)) == NULL)
+		return FAIL;
+	free_before = frames_free;
+	for(i = 0; i < KM_TEST_OBJS; i++) {
+		size = (i % 2) ? 200 : KMALLOC_MIN << (i % KMALLOC_CLASSES);
+		objs[i] = (i % 2) ? kmem_cache_alloc(cache) : kmalloc(size);
+		if(objs[i] == NULL)
+			return FAIL;
+		memset(objs[i], i, size);
+	}
+	big = kmalloc(3 * _4_KB);
+	if(big == NULL)
+		return FAIL;
+	memset(big, 0xAA, 3 * _4_KB);
+	for(i = 0; i < KM_TEST_OBJS; i++) {
+		size = (i % 2) ? 200 : KMALLOC_MIN << (i % KMALLOC_CLASSES);
+		for(j = 0; j < size; j++)
+			if(objs[i][j] != (uint8_t)i)
+				result = FAIL;
+	}
+	kmalloc_stats();
+	for(i = 0; i < KM_TEST_OBJS; i++) {
+		if(i % 2) kmem_cache_free(cache, objs[i]);
+		else kfree(objs[i]);
+	}
+	kfree(big);
+	// each cache may keep one empty slab
+	if(frames_free + KMALLOC_CLASSES + 1 < free_before)
+		result = FAIL;
+	return result;
+}
+
+/* first fit allocator the slab caches are compared against: blocks with a
+ * size/used header in one arena, searched from the start every time */
+#define FF_ARENA_SIZE	(64 * _4_KB)
+#define FF_HDR			sizeof(uint32_t)
+#define FF_USED			1
+static uint32_t ff_arena[FF_ARENA_SIZE / FOUR_BYTE];
+
+static void ff_init(void) {
+	ff_arena[0] = FF_ARENA_SIZE;
+}
+
+static void* ff_alloc(uint32_t size) {
+	uint8_t* p = (uint8_t*)ff_arena;
+	uint8_t* end = p + FF_ARENA_SIZE;
+	uint32_t blk, rest;
+	size = (size + FF_HDR + FOUR_BYTE - 1) & ~(FOUR_BYTE - 1);
+	for(; p < end; p += blk) {
+		blk = *(uint32_t*)p & ~FF_USED;
+		if(*(uint32_t*)p & FF_USED || blk < size)
+			continue;
+		rest = blk - size;
+		if(rest > FF_HDR) {
+			*(uint32_t*)(p + size) = rest;
+			blk = size;
+		}
+		*(uint32_t*)p = blk | FF_USED;
+		return p + FF_HDR;
+	}
+	return NULL;
+}
+
+static void ff_free(void* ptr) {
+	uint8_t* p = (uint8_t*)ptr - FF_HDR;
+	uint8_t* end = (uint8_t*)ff_arena + FF_ARENA_SIZE;
+	uint32_t blk = *(uint32_t*)p & ~FF_USED;
+	// merge with the free block after it
+	if(p + blk < end && !(*(uint32_t*)(p + blk) & FF_USED))
+		blk += *(uint32_t*)(p + blk);
+	*(uint32_t*)p = blk;
+}
+
+/* kmalloc_bench - CP5
+ * DESCRIPTION: times BENCH_ITERS rounds of allocating KM_TEST_OBJS objects
+ *              of mixed kernel object sizes, freeing every other one,
+ *              allocating those again and freeing everything, once with
+ *              the slab caches and once with the first fit allocator
+ * INPUTS: none
+ * OUTPUTS: average cycles per allocation + free for each
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: none
+ */
+int kmalloc_bench() {
+	TEST_HEADER;
+	static void* objs[KM_TEST_OBJS];
+	static const uint32_t sizes[] = {16, 24, 60, 200, 100, 40, 300, 32};
+	uint32_t i, j, start, slab, ff, ops;
+
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++) {
+		for(j = 0; j < KM_TEST_OBJS; j++)
+			objs[j] = kmalloc(sizes[j % 8]);
+		for(j = 0; j < KM_TEST_OBJS; j += 2)
+			kfree(objs[j]);
+		for(j = 0; j < KM_TEST_OBJS; j += 2)
+			objs[j] = kmalloc(sizes[(j + 3) % 8]);
+		for(j = 0; j < KM_TEST_OBJS; j++)
+			kfree(objs[j]);
+	}
+	slab = rdtsc() - start;
+
+	ff_init();
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++) {
+		for(j = 0; j < KM_TEST_OBJS; j++)
+			objs[j] = ff_alloc(sizes[j % 8]);
+		for(j = 0; j < KM_TEST_OBJS; j += 2)
+			ff_free(objs[j]);
+		for(j = 0; j < KM_TEST_OBJS; j += 2)
+			objs[j] = ff_alloc(sizes[(j + 3) % 8]);
+		for(j = KM_TEST_OBJS; j > 0; j--)
+			ff_free(objs[j - 1]);
+	}
+	ff = rdtsc() - start;
+
+	ops = BENCH_ITERS * (KM_TEST_OBJS + KM_TEST_OBJS / 2);
+	printf("alloc + free: slab %u cycles, first fit %u cycles\n", slab / ops, ff / ops);
+	return PASS;
+}
+
+/* mem_test - CP5
+ * DESCRIPTION: runs memcpy, memset and memmove with every strategy
+ *              mem_init may pick, over sizes that hit each size class and
+ *              every alignment of source and destination, checking the
+ *              bytes around the destination are left alone. memmove is
+ *              also run with overlapping buffers in both directions.
+ * INPUTS: none
+ * OUTPUTS: none
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: none
+ */
+#define MEM_TEST_SIZE	(_4_KB + SSE_BLOCK)
+#define MEM_TEST_GUARD	0xEE
+static uint8_t mem_src[MEM_TEST_SIZE + SSE_BLOCK];
+static uint8_t mem_dst[MEM_TEST_SIZE + SSE_BLOCK];
+
+/* mem_check
+ * DESCRIPTION: checks mem_dst holds guard bytes outside [off, off + n)
+ *              and the expected bytes inside
+ * INPUTS: off, n - range that was written
+ *         src - expected bytes, NULL if every byte should be c
+ *         c - expected byte for a memset
+ * RETURN VALUE: PASS / FAIL
+ */
+static int mem_check(uint32_t off, uint32_t n, const uint8_t* src, uint8_t c) {
+	uint32_t i;
+	for(i = 0; i < sizeof(mem_dst); i++) {
+		if(i < off || i >= off + n) {
+			if(mem_dst[i] != MEM_TEST_GUARD)
+				return FAIL;
+		} else if(mem_dst[i] != (src != NULL ? src[i - off] : c)) {
+			return FAIL;
+		}
+	}
+	return PASS;
+}
+
+int mem_test() {
+	TEST_HEADER;
+	static const uint32_t sizes[] = {0, 1, 3, 4, 7, 15, 16, 17, 31, 63, 64,
+		65, 100, 255, 1023, 1024, 1025, 2000, _4_KB};
+	static const int32_t shifts[] = {-17, -5, -1, 1, 3, 17};
+	uint32_t saved = mem_features;
+	uint32_t features, i, j, da, sa;
+	int result = PASS;
+
+	for(i = 0; i < sizeof(mem_src); i++)
+		mem_src[i] = i * 7 + 3;
+	// every strategy the CPU supports, down to none
+	for(features = saved + 1; features-- > 0 && result == PASS; ) {
+		if(features & ~saved)
+			continue;
+		mem_features = features;
+		for(j = 0; j < sizeof(sizes) / sizeof(sizes[0]) && result == PASS; j++) {
+			for(da = 0; da < FOUR_BYTE && result == PASS; da++) {
+				for(sa = 0; sa < FOUR_BYTE && result == PASS; sa++) {
+					(memset)(mem_dst, MEM_TEST_GUARD, sizeof(mem_dst));
+					memcpy(mem_dst + SSE_ALIGN + da, mem_src + sa, sizes[j]);
+					if(mem_check(SSE_ALIGN + da, sizes[j], mem_src + sa, 0) == FAIL) {
+						printf("memcpy of %u bytes failed, features %u\n", sizes[j], features);
+						result = FAIL;
+					}
+					(memset)(mem_dst, MEM_TEST_GUARD, sizeof(mem_dst));
+					memset(mem_dst + SSE_ALIGN + da, sa + 1, sizes[j]);
+					if(mem_check(SSE_ALIGN + da, sizes[j], NULL, sa + 1) == FAIL) {
+						printf("memset of %u bytes failed, features %u\n", sizes[j], features);
+						result = FAIL;
+					}
+				}
+			}
+			// overlapping moves, dest below and above src
+			for(i = 0; i < sizeof(shifts) / sizeof(shifts[0]) && result == PASS; i++) {
+				memcpy(mem_dst, mem_src, sizeof(mem_dst));
+				memmove(mem_dst + SSE_BLOCK / 2 + shifts[i], mem_dst + SSE_BLOCK / 2, sizes[j]);
+				for(sa = 0; sa < sizeof(mem_dst); sa++) {
+					da = sa - (SSE_BLOCK / 2 + shifts[i]);
+					if(mem_dst[sa] != (da < sizes[j] ? mem_src[SSE_BLOCK / 2 + da] : mem_src[sa])) {
+						printf("memmove of %u bytes by %d failed, features %u\n", sizes[j], shifts[i], features);
+						result = FAIL;
+						break;
+					}
+				}
+			}
+		}
+	}
+	mem_features = saved;
+	return result;
+}
+
+/* mem_bench - CP5
+ * DESCRIPTION: times BENCH_ITERS copies and fills of sizes from a file name
+ *              up to a data block with each strategy the CPU supports.
+ *              Both buffers stay in the cache, so this is the cost of the
+ *              instructions, not of memory.
+ * INPUTS: none
+ * OUTPUTS: cycles per byte (two decimals) for each size and strategy
+ * RETURN VALUE: PASS
+ * SIDE EFFECTS: none
+ */
+int mem_bench() {
+	TEST_HEADER;
+	static const uint32_t sizes[] = {32, 128, 512, 1024, _4_KB};
+	static const int8_t* names[] = {"movsl", "sse", "erms", "sse+erms"};
+	uint32_t saved = mem_features;
+	uint32_t avail = saved & (MEM_SSE | MEM_ERMS);
+	uint32_t features, i, j, start, copy, set;
+
+	for(features = 0; features <= avail; features++) {
+		if(features & ~avail)
+			continue;
+		mem_features = features;
+		printf("%s:\n", names[features]);
+		for(j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+			start = rdtsc();
+			for(i = 0; i < BENCH_ITERS; i++)
+				memcpy(mem_dst + 1, mem_src, sizes[j]);
+			copy = (rdtsc() - start) * 100 / (BENCH_ITERS * sizes[j]);
+			start = rdtsc();
+			for(i = 0; i < BENCH_ITERS; i++)
+				memset(mem_dst, i, sizes[j]);
+			set = (rdtsc() - start) * 100 / (BENCH_ITERS * sizes[j]);
+			printf("  %u bytes: memcpy %u.%u%u, memset %u.%u%u cycles/byte\n", sizes[j],
+			       copy / 100, copy / 10 % 10, copy % 10, set / 100, set / 10 % 10, set % 10);
+		}
+	}
+	mem_features = saved;
+	return PASS;
+}
+
+/* str_test - CP5
+ * DESCRIPTION: checks strlen, strcpy, strncpy and strncmp against byte at
+ *              a time expectations for every length up to a few words and
+ *              every alignment of the strings, then file name lookups with
+ *              and without the SSE2 compare
+ * INPUTS: none
+ * OUTPUTS: none
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: none
+ */
+#define STR_TEST_LEN	40
+#define STR_TEST_BUF	64
+int str_test() {
+	TEST_HEADER;
+	static int8_t a[STR_TEST_BUF], b[STR_TEST_BUF];
+	uint32_t saved = mem_features;
+	uint32_t len, sa, da, i, n;
+	dentry_t dentry;
+	int result = PASS;
+
+	for(len = 0; len < STR_TEST_LEN && result == PASS; len++) {
+		for(sa = 0; sa < FOUR_BYTE; sa++) {
+			for(i = 0; i < STR_TEST_BUF; i++)
+				a[i] = (i >= sa && i < sa + len) ? 'a' + i % 26 : 'x';
+			a[sa + len] = '\0';
+			if(strlen(a + sa) != len)
+				result = FAIL;
+			for(da = 0; da < FOUR_BYTE; da++) {
+				memset(b, 'y', STR_TEST_BUF);
+				strcpy(b + da, a + sa);
+				if(strncmp(b + da, a + sa, STR_TEST_BUF) != 0 || b[da + len + 1] != 'y')
+					result = FAIL;
+				// strncpy stops at n and zero fills past the string
+				n = len / 2 + da;
+				memset(b, 'y', STR_TEST_BUF);
+				strncpy(b + da, a + sa, n);
+				for(i = 0; i < n; i++)
+					if(b[da + i] != (i < len ? a[sa + i] : '\0'))
+						result = FAIL;
+				if(b[da + n] != 'y')
+					result = FAIL;
+				// a difference in the last byte, then in the terminator
+				strcpy(b + da, a + sa);
+				if(len > 0) {
+					b[da + len - 1]++;
+					if(strncmp(a + sa, b + da, len) >= 0 || strncmp(b + da, a + sa, len) <= 0)
+						result = FAIL;
+					if(strncmp(a + sa, b + da, len - 1) != 0)
+						result = FAIL;
+					b[da + len - 1]--;
+				}
+				b[da + len] = 'z';
+				b[da + len + 1] = '\0';
+				if(strncmp(a + sa, b + da, len + 1) >= 0 || strncmp(a + sa, b + da, len) != 0)
+					result = FAIL;
+			}
+		}
+	}
+	if(result == FAIL)
+		printf("string functions failed at length %u\n", len - 1);
+
+	// every file is found by its own name, a prefix or extension of one is not
+	for(n = 0; n < 2 && result == PASS; n++) {
+		mem_features = n ? saved : saved & ~MEM_SSE2;
+		for(i = 0; i < boot->num_of_dirE; i++) {
+			strncpy(a, (int8_t*)boot->dir_entries[i].file_name, NAME_SIZE);
+			a[NAME_SIZE] = '\0';
+			if((len = strlen(a)) == 0)
+				continue;
+			if(read_dentry_by_name((uint8_t*)a, &dentry) != 0 ||
+			   strncmp((int8_t*)dentry.file_name, a, NAME_SIZE) != 0)
+				result = FAIL;
+			a[len - 1] = '\0';
+			if(len > 1 && read_dentry_by_name((uint8_t*)a, &dentry) == 0 &&
+			   strncmp((int8_t*)dentry.file_name, a, NAME_SIZE) != 0)
+				result = FAIL;
+			if(len < NAME_SIZE) {
+				a[len - 1] = boot->dir_entries[i].file_name[len - 1];
+				a[len] = '~';
+				a[len + 1] = '\0';
+				if(read_dentry_by_name((uint8_t*)a, &dentry) == 0)
+					result = FAIL;
+			}
+		}
+	}
+	mem_features = saved;
+	return result;
+}
+
+/* byte_strncmp
+ * DESCRIPTION: the old byte at a time strncmp, kept as a baseline for
+ *              str_bench
+ * INPUTS: s1, s2, n
+ * RETURN VALUE: difference of the first bytes that differ, 0 if equal
+ */
+static int32_t byte_strncmp(const int8_t* s1, const int8_t* s2, uint32_t n) {
+	uint32_t i;
+	for(i = 0; i < n; i++) {
+		if(s1[i] != s2[i] || s1[i] == '\0')
+			return s1[i] - s2[i];
+	}
+	return 0;
+}
+
+/* str_bench - CP5
+ * DESCRIPTION: times BENCH_ITERS rounds of comparing every file name with
+ *              itself byte at a time and with strncmp, and of looking every
+ *              file up with and without the SSE2 name compare
+ * INPUTS: none
+ * OUTPUTS: average cycles per compare and per lookup
+ * RETURN VALUE: PASS / FAIL
+ * SIDE EFFECTS: none
+ */
+int str_bench() {
+	TEST_HEADER;
+	static int8_t names[MAX_FILE_COUNT][NAME_SIZE + 1];
+	uint32_t saved = mem_features;
+	uint32_t i, j, count, start, bytes, words, sse, plain;
+	dentry_t dentry;
+	int result = PASS;
+
+	count = boot->num_of_dirE;
+	if(count == 0 || count > MAX_FILE_COUNT)
+		return FAIL;
+	for(j = 0; j < count; j++) {
+		strncpy(names[j], (int8_t*)boot->dir_entries[j].file_name, NAME_SIZE);
+		names[j][NAME_SIZE] = '\0';
+	}
+
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++)
+		for(j = 0; j < count; j++)
+			byte_strncmp(names[j], (int8_t*)boot->dir_entries[j].file_name, NAME_SIZE);
+	bytes = rdtsc() - start;
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++)
+		for(j = 0; j < count; j++)
+			strncmp(names[j], (int8_t*)boot->dir_entries[j].file_name, NAME_SIZE);
+	words = rdtsc() - start;
+
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++)
+		for(j = 0; j < count; j++)
+			if(read_dentry_by_name((uint8_t*)names[j], &dentry) != 0)
+				result = FAIL;
+	sse = rdtsc() - start;
+	mem_features = saved & ~MEM_SSE2;
+	start = rdtsc();
+	for(i = 0; i < BENCH_ITERS; i++)
+		for(j = 0; j < count; j++)
+			if(read_dentry_by_name((uint8_t*)names[j], &dentry) != 0)
+				result = FAIL;
+	plain = rdtsc() - start;
+	mem_features = saved;
+
+	count *= BENCH_ITERS;
+	printf("name compare: byte %u cycles, word %u cycles\n", bytes / count, words / count);
+	printf("lookup: %s %u cycles, strncmp %u cycles\n",
+	       (saved & MEM_SSE2) ? "sse2" : "strncmp (no sse2)", sse / count, plain / count);
+	return result;
+}
 
 /* Test suite entry point */
 void launch_tests(){
@@ -381,4 +1104,17 @@ void launch_tests(){
 	// list_dir_test();
 	// read_file_large();
 	// TEST_OUTPUT("read_nonexistant_file_test", read_nonexistent_file_test());
+	// TEST_OUTPUT("rtc_virtual_test", rtc_virtual_test());
+	// TEST_OUTPUT("dentry_index_test", dentry_index_test());
+	// TEST_OUTPUT("dentry_lookup_bench", dentry_lookup_bench());
+	// TEST_OUTPUT("terminal_write_bench", terminal_write_bench());
+	// TEST_OUTPUT("switch_display_bench", switch_display_bench());
+	// TEST_OUTPUT("tlb_switch_bench", tlb_switch_bench());
+	// TEST_OUTPUT("exec_cache_test", exec_cache_test());
+	// TEST_OUTPUT("kmalloc_test", kmalloc_test());
+	// TEST_OUTPUT("kmalloc_bench", kmalloc_bench());
+	// TEST_OUTPUT("mem_test", mem_test());
+	// TEST_OUTPUT("mem_bench", mem_bench());
+	// TEST_OUTPUT("str_test", str_test());
+	// TEST_OUTPUT("str_bench", str_bench());
 }
@@ -11,11 +11,14 @@
 #define _1_KB            0x400
 #define _4_KB            0x1000
 #define _8_KB            0x2000
+#define _1_MB            0x100000
 #define _4_MB            0x400000
 #define _8_MB            0x800000
 #define _128_MB          0x8000000
 #define _132_MB          0x8400000
 #define _140_MB          0x8C00000
+#define _144_MB          0x9000000
+#define _148_MB          0x9400000
 #define VID_MEM          0xB8000
 
 #ifndef ASM
@@ -0,0 +1,22 @@
+#ifndef _WAIT_QUEUE_H
+#define _WAIT_QUEUE_H
+
+#include "types.h"
+
+// end of a wait queue / run queue link
+#define NO_PID              -1
+
+// processes blocked on an event, linked through pcb->wait_next
+typedef struct wait_queue {
+    int32_t head;
+    int32_t tail;
+} wait_queue_t;
+
+#define WAIT_QUEUE_INIT     { NO_PID, NO_PID }
+
+// blocks the running process on a wait queue until woken (scheduler.c)
+void sleep_on(wait_queue_t* wq);
+// moves every process on a wait queue back to the run queue (scheduler.c)
+void wake_up(wait_queue_t* wq);
+
+#endif
@@ -7,17 +7,23 @@ int main ()
 {
     int32_t fd, cnt;
     uint8_t buf[1024];
+    uint8_t* data;
 
+    /* without a file name copy stdin, e.g. the output of a pipe */
     if (0 != ece391_getargs (buf, 1024)) {
-        ece391_fdputs (1, (uint8_t*)"could not read arguments\n");
-	return 3;
-    }
-
-    if (-1 == (fd = ece391_open (buf))) {
+	fd = 0;
+    } else if (-1 == (fd = ece391_open (buf))) {
         ece391_fdputs (1, (uint8_t*)"file not found\n");
 	return 2;
     }
 
+    /* write straight out of the mapped file if the kernel can map it */
+    if (-1 != (cnt = ece391_mmap (fd, &data))) {
+	if (-1 == ece391_write (1, data, cnt))
+	    return 3;
+	return 0;
+    }
+
     while (0 != (cnt = ece391_read (fd, buf, 1024))) {
         if (-1 == cnt) {
 	    ece391_fdputs (1, (uint8_t*)"file read failed\n");
@@ -0,0 +1,46 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 32
+#define WAIT_TICKS 8
+
+static uint32_t shared = 1;
+
+/*
+ * Copy-on-write fork test. The child writes to a page it shares with the
+ * parent and prints what it sees, the parent waits a few RTC ticks for it
+ * and checks that its own copy did not change.
+ */
+int main ()
+{
+    int32_t pid, rtc, i, garbage;
+    uint8_t buf[BUFSIZE];
+
+    pid = ece391_fork ();
+    if (-1 == pid) {
+        ece391_fdputs (1, (uint8_t*)"forktest: fork failed\n");
+        return 1;
+    }
+    if (0 == pid) {
+        shared = 2;
+        ece391_fdputs (1, (uint8_t*)"forktest: child sees ");
+        ece391_fdputs (1, ece391_itoa (shared, buf, 10));
+        ece391_fdputs (1, (uint8_t*)"\n");
+        return 0;
+    }
+
+    ece391_fdputs (1, (uint8_t*)"forktest: forked pid ");
+    ece391_fdputs (1, ece391_itoa (pid, buf, 10));
+    ece391_fdputs (1, (uint8_t*)"\n");
+    if (-1 != (rtc = ece391_open ((uint8_t*)"rtc"))) {
+        for (i = 0; i < WAIT_TICKS; i++)
+            ece391_read (rtc, &garbage, 4);
+        ece391_close (rtc);
+    }
+    ece391_fdputs (1, (uint8_t*)"forktest: parent sees ");
+    ece391_fdputs (1, ece391_itoa (shared, buf, 10));
+    ece391_fdputs (1, (uint8_t*)(1 == shared ? "\n" : ", copy-on-write broken\n"));
+    return 1 != shared;
+}
@@ -95,4 +95,3 @@ int main ()
 
     return 0;
 }
-strcpy((int8_t*)pcb->arg, (int8_t*)argb);
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 32
+#define NODES 10000
+#define BIG_SIZE (256 * 1024)
+
+typedef struct node {
+    struct node* next;
+    uint32_t value;
+} node_t;
+
+/*
+ * User heap test. Builds a list bigger than any stack buffer with
+ * ece391_malloc, checks and frees it, then takes a block large enough to
+ * get its own anonymous mapping.
+ */
+int main ()
+{
+    node_t* head = 0;
+    node_t* n;
+    uint8_t* big;
+    uint32_t i, sum = 0;
+    uint8_t buf[BUFSIZE];
+
+    for (i = 0; i < NODES; i++) {
+        if (0 == (n = ece391_malloc (sizeof (node_t)))) {
+            ece391_fdputs (1, (uint8_t*)"heaptest: malloc failed\n");
+            return 1;
+        }
+        n->value = i;
+        n->next = head;
+        head = n;
+    }
+    while (0 != head) {
+        n = head;
+        sum += n->value;
+        head = n->next;
+        ece391_free (n);
+    }
+    ece391_fdputs (1, (uint8_t*)"heaptest: list sum ");
+    ece391_fdputs (1, ece391_itoa (sum, buf, 10));
+    ece391_fdputs (1, (uint8_t*)(NODES * (NODES - 1) / 2 == sum ? " ok\n" : " wrong\n"));
+
+    if (0 == (big = ece391_malloc (BIG_SIZE))) {
+        ece391_fdputs (1, (uint8_t*)"heaptest: big malloc failed\n");
+        return 1;
+    }
+    for (i = 0; i < BIG_SIZE; i += 4096)
+        big[i] = 1;
+    ece391_free (big);
+    ece391_fdputs (1, (uint8_t*)"heaptest: big block ok\n");
+    return 0;
+}
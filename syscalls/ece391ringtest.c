@@ -0,0 +1,65 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391sysnum.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 32
+#define LINES 16
+
+/*
+ * System call ring test. Queues an open, a read and a close of a file
+ * plus a batch of terminal writes, enters the kernel once and checks the
+ * completions.
+ */
+int main ()
+{
+    syscall_ring_t* ring;
+    ring_sqe_t* sqe;
+    ring_cqe_t* cqe;
+    uint8_t buf[BUFSIZE];
+    static uint8_t line[] = "ringtest: queued write\n";
+    int32_t i, ran, fd = 2, bad = 0;
+
+    if (-1 == ece391_ring_setup (&ring)) {
+        ece391_fdputs (1, (uint8_t*)"ringtest: ring_setup failed\n");
+        return 1;
+    }
+
+    /* fd 2 is the first free descriptor of a new program */
+    sqe = &ring->sq[ring->sq_tail++ % RING_ENTRIES];
+    sqe->op = SYS_OPEN;
+    sqe->arg[0] = (int32_t)"frame0.txt";
+    sqe->user_data = 0;
+    sqe = &ring->sq[ring->sq_tail++ % RING_ENTRIES];
+    sqe->op = SYS_READ;
+    sqe->arg[0] = fd;
+    sqe->arg[1] = (int32_t)buf;
+    sqe->arg[2] = BUFSIZE;
+    sqe->user_data = 1;
+    sqe = &ring->sq[ring->sq_tail++ % RING_ENTRIES];
+    sqe->op = SYS_CLOSE;
+    sqe->arg[0] = fd;
+    sqe->user_data = 2;
+    for (i = 0; i < LINES; i++) {
+        sqe = &ring->sq[ring->sq_tail++ % RING_ENTRIES];
+        sqe->op = SYS_WRITE;
+        sqe->arg[0] = 1;
+        sqe->arg[1] = (int32_t)line;
+        sqe->arg[2] = sizeof (line) - 1;
+        sqe->user_data = 3 + i;
+    }
+
+    ran = ece391_ring_enter (RING_ENTRIES);
+    while (ring->cq_head != ring->cq_tail) {
+        cqe = &ring->cq[ring->cq_head++ % RING_ENTRIES];
+        if (cqe->result < 0)
+            bad++;
+    }
+    ece391_fdputs (1, (uint8_t*)"ringtest: ");
+    ece391_fdputs (1, ece391_itoa (ran, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" calls in one trap, ");
+    ece391_fdputs (1, ece391_itoa (bad, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" failed\n");
+    return 0 != bad;
+}
@@ -4,6 +4,79 @@
 #include "ece391syscall.h"
 
 #define BUFSIZE 1024
+#define MAX_STAGES 8
+#define SAVED_STDIN 7
+
+/*
+ * Runs a line of the form "a | b | c". Every stage but the last is forked
+ * and executed with its stdout on a pipe to the next stage, so they all run
+ * at once and a full pipe holds the writer back. The last stage runs in the
+ * shell like a plain command, reading the previous pipe as stdin, and its
+ * result is the line's.
+ */
+static int32_t
+run_pipeline (uint8_t* line)
+{
+    uint8_t* stage[MAX_STAGES];
+    int32_t n, i, j, fds[2], pid, rval;
+    int32_t in = -1;
+
+    stage[0] = line;
+    n = 1;
+    for (i = 0; '\0' != line[i]; i++) {
+	if ('|' == line[i]) {
+	    if (MAX_STAGES == n)
+		return -1;
+	    /* trailing blanks would become part of the stage's arguments */
+	    for (j = i; j > 0 && ' ' == line[j - 1]; j--)
+		line[j - 1] = '\0';
+	    line[i] = '\0';
+	    stage[n++] = &line[i + 1];
+	}
+    }
+    if (1 == n)
+	return ece391_execute (line);
+
+    for (i = 0; i < n - 1; i++) {
+	if (-1 == ece391_pipe (fds)) {
+	    if (-1 != in)
+		ece391_close (in);
+	    return -1;
+	}
+	if (-1 == (pid = ece391_fork ())) {
+	    ece391_close (fds[0]);
+	    ece391_close (fds[1]);
+	    if (-1 != in)
+		ece391_close (in);
+	    return -1;
+	}
+	if (0 == pid) {
+	    /* child: previous pipe in, this one out, then become the stage */
+	    if (-1 != in) {
+		ece391_dup2 (in, 0);
+		ece391_close (in);
+	    }
+	    ece391_dup2 (fds[1], 1);
+	    ece391_close (fds[0]);
+	    ece391_close (fds[1]);
+	    ece391_halt (ece391_execute (stage[i]));
+	}
+	/* the write end now belongs to the child alone, so the next stage
+	   sees end of file when the child is done */
+	if (-1 != in)
+	    ece391_close (in);
+	ece391_close (fds[1]);
+	in = fds[0];
+    }
+
+    ece391_dup2 (0, SAVED_STDIN);
+    ece391_dup2 (in, 0);
+    ece391_close (in);
+    rval = ece391_execute (stage[n - 1]);
+    ece391_dup2 (SAVED_STDIN, 0);
+    ece391_close (SAVED_STDIN);
+    return rval;
+}
 
 int main ()
 {
@@ -24,7 +97,7 @@ int main ()
 	    return 0;
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
+	rval = run_pipeline (buf);
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
@@ -0,0 +1,70 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 32
+#define SLOTS 1000
+#define COUNT 100000
+/* where the producer maps the segment, 1MB into the anonymous window */
+#define PRODUCER_ADDR ((uint8_t*)0x9500000)
+
+typedef struct {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t data[SLOTS];
+} queue_t;
+
+/*
+ * Shared memory test. The parent maps a named segment and forks a
+ * producer, which maps the same name again at an address of its choosing
+ * and pushes COUNT numbers through a queue in the segment. The parent
+ * consumes them by polling, no system call is made per number.
+ */
+int main ()
+{
+    queue_t* q = 0;
+    queue_t* pq = (queue_t*)PRODUCER_ADDR;
+    uint32_t i, sum = 0;
+    int32_t pid;
+    uint8_t buf[BUFSIZE];
+
+    if (-1 == ece391_shm_map ((uint8_t*)"shmtest", sizeof (queue_t), (uint8_t**)&q)) {
+        ece391_fdputs (1, (uint8_t*)"shmtest: shm_map failed\n");
+        return 1;
+    }
+    if (-1 == (pid = ece391_fork ())) {
+        ece391_fdputs (1, (uint8_t*)"shmtest: fork failed\n");
+        return 1;
+    }
+    if (0 == pid) {
+        if (-1 == ece391_shm_map ((uint8_t*)"shmtest", sizeof (queue_t), (uint8_t**)&pq)) {
+            ece391_fdputs (1, (uint8_t*)"shmtest: producer shm_map failed\n");
+            return 1;
+        }
+        for (i = 1; i <= COUNT; i++) {
+            while (pq->tail - pq->head == SLOTS);
+            pq->data[pq->tail % SLOTS] = i;
+            pq->tail++;
+        }
+        return 0;
+    }
+
+    for (i = 0; i < COUNT; i++) {
+        while (q->head == q->tail);
+        sum += q->data[q->head % SLOTS];
+        q->head++;
+    }
+    ece391_fdputs (1, (uint8_t*)"shmtest: consumed ");
+    ece391_fdputs (1, ece391_itoa (COUNT, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" numbers, sum ");
+    ece391_fdputs (1, ece391_itoa (sum, buf, 10));
+    if ((uint32_t)COUNT * (COUNT + 1) / 2 != sum) {
+        ece391_fdputs (1, (uint8_t*)", expected ");
+        ece391_fdputs (1, ece391_itoa ((uint32_t)COUNT * (COUNT + 1) / 2, buf, 10));
+        ece391_fdputs (1, (uint8_t*)"\n");
+        return 1;
+    }
+    ece391_fdputs (1, (uint8_t*)"\n");
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 64
+
+/*
+ * Process table stress test. Every copy executes another copy of itself
+ * with its depth as the argument, so the processes nest until the kernel
+ * runs out of pids or memory. The deepest one reports how many were alive
+ * at once, the rest pass its status back up.
+ */
+int main ()
+{
+    uint32_t depth = 0;
+    int32_t i, rval;
+    uint8_t buf[BUFSIZE], cmd[BUFSIZE] = "stress ";
+
+    if (0 == ece391_getargs (buf, BUFSIZE))
+        for (i = 0; buf[i] >= '0' && buf[i] <= '9'; i++)
+            depth = depth * 10 + buf[i] - '0';
+    depth++;
+
+    ece391_itoa (depth, buf, 10);
+    ece391_strcpy (cmd + ece391_strlen (cmd), buf);
+    rval = ece391_execute (cmd);
+    if (-1 == rval) {
+        ece391_fdputs (1, (uint8_t*)"stress: ");
+        ece391_fdputs (1, buf);
+        ece391_fdputs (1, (uint8_t*)" nested processes before execute failed\n");
+        return 0;
+    }
+    if (256 == rval) {
+        ece391_fdputs (1, (uint8_t*)"stress: ");
+        ece391_fdputs (1, buf);
+        ece391_fdputs (1, (uint8_t*)" nested processes before memory ran out\n");
+        return 0;
+    }
+    return rval;
+}
@@ -0,0 +1,48 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 32
+#define ITERS 100000
+
+/* Low 32 bits of the time-stamp counter */
+static inline uint32_t rdtsc (void)
+{
+    uint32_t lo, hi;
+    asm volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return lo;
+}
+
+static void print_result (const char* name, uint32_t cycles)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_fdputs (1, (uint8_t*)name);
+    ece391_fdputs (1, ece391_itoa (cycles / ITERS, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" cycles per call\n");
+}
+
+/*
+ * Null system call round trip. sigreturn returns right away in the
+ * kernel, so the time is the cost of getting in and out: int $0x80 and
+ * iret against sysenter and sysexit.
+ */
+int main ()
+{
+    uint32_t i, start, slow, fast;
+
+    start = rdtsc ();
+    for (i = 0; i < ITERS; i++)
+        ece391_sigreturn ();
+    slow = rdtsc () - start;
+
+    start = rdtsc ();
+    for (i = 0; i < ITERS; i++)
+        ece391_fast_sigreturn ();
+    fast = rdtsc () - start;
+
+    print_result ("sysbench: int $0x80  ", slow);
+    print_result ("sysbench: sysenter   ", fast);
+    return 0;
+}
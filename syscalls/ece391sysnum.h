@@ -11,5 +11,15 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_MMAP    11
+#define SYS_FORK    12
+#define SYS_SBRK    13
+#define SYS_MMAP_ANON  14
+#define SYS_MUNMAP  15
+#define SYS_RING_SETUP  16
+#define SYS_RING_ENTER  17
+#define SYS_PIPE    18
+#define SYS_DUP2    19
+#define SYS_SHM_MAP  20
 
 #endif /* ECE391SYSNUM_H */